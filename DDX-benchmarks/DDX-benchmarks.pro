@@ -0,0 +1,66 @@
+################################################################################
+##                         DATA DISPLAY APPLICATION X                         ##
+##                            2B TECHNOLOGIES, INC.                           ##
+##                                                                            ##
+## The DDX is free software: you can redistribute it and/or modify it under   ##
+## the terms of the GNU General Public License as published by the Free       ##
+## Software Foundation, either version 3 of the License, or (at your option)  ##
+## any later version.  The DDX is distributed in the hope that it will be     ##
+## useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     ##
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  ##
+## Public License for more details.  You should have received a copy of the   ##
+## GNU General Public License along with the DDX.  If not, see                ##
+## <http://www.gnu.org/licenses/>.                                            ##
+##                                                                            ##
+##  For more information about the DDX, check out the 2B website or GitHub:   ##
+##       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      ##
+################################################################################
+
+
+# QBENCHMARK timings of the daemon's hot paths, built against its sources
+# Run with -median 5 for steadier numbers
+
+QT       += core \
+			network \
+			serialport \
+			bluetooth \
+			widgets \
+			testlib
+
+QT       -= gui
+
+TARGET = DDX-benchmarks
+CONFIG   += c++11
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../DDX-daemon
+
+
+SOURCES += main.cpp \
+    pathbench.cpp \
+    batchbenchmark.cpp \
+    numberformatbenchmark.cpp \
+    decimatebenchmark.cpp \
+    shardbenchmark.cpp
+
+HEADERS += \
+    pathbench.h \
+    batchbenchmark.h \
+    numberformatbenchmark.h \
+    decimatebenchmark.h \
+    shardbenchmark.h
+
+include(../DDX-daemon/DDX-daemon.pri)
+
+# Timings are only meaningful with the daemon's release optimizations
+QMAKE_CFLAGS_RELEASE -= -O
+QMAKE_CFLAGS_RELEASE -= -O1
+QMAKE_CFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CFLAGS_RELEASE *= -O3
+QMAKE_CXXFLAGS_RELEASE *= -O3
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "batchbenchmark.h"
+#include <QtTest>
+#include <cmath>
+#include "pathbench.h"
+#include "modules/parsemodule.h"
+#include "modules/windowmodule.h"
+
+//! Lines sent per iteration
+static const int lines = 10000;
+
+void BatchBenchmark::initTestCase() {
+	values.resize(lines);
+	for (int i = 0; i < lines; ++i)
+		values[i] = QByteArray::number(40 + 10 * std::sin(i / 100.0), 'f', 3);
+}
+
+void BatchBenchmark::batch_data() {
+	QTest::addColumn<int>("batchSize");
+	QTest::newRow("1") << 1;
+	QTest::newRow("16") << 16;
+	QTest::newRow("256") << 256;
+	QTest::newRow("4096") << 4096;
+}
+
+void BatchBenchmark::batch() {
+	QFETCH(int, batchSize);
+	PathBench bench("Batch benchmark");
+	Column *value = build(bench);
+	bench.configure(batchSize);
+	QBENCHMARK {
+		send(bench, value);
+	}
+}
+
+void BatchBenchmark::plan_data() {
+	QTest::addColumn<int>("batchSize");
+	QTest::addColumn<bool>("fused");
+	QTest::newRow("line by line") << 1 << false;
+	QTest::newRow("batch steps") << 256 << false;
+	QTest::newRow("fused") << 256 << true;
+}
+
+void BatchBenchmark::plan() {
+	QFETCH(int, batchSize);
+	QFETCH(bool, fused);
+	PathBench bench("Plan benchmark");
+	Column *value = build(bench);
+	bench.configure(batchSize);
+	if ( ! fused) bench.unfuse();
+	QBENCHMARK {
+		send(bench, value);
+	}
+}
+
+Column *BatchBenchmark::build(PathBench &bench) {
+	Column *value = bench.inlet()->addColumn("Value", Column::Text);
+	bench.append<ParseModule>("Parse", "{\"Columns\": [\"Value\"]}");
+	bench.append<WindowModule>("Window", "{\"Columns\": [\"Value\"], \"Window\": 100}");
+	bench.append<BenchSink>("Sink");
+	return value;
+}
+
+void BatchBenchmark::send(PathBench &bench, Column *value) const {
+	for (int i = 0; i < lines; ++i) {
+		value->setText(values.at(i));
+		bench.line();
+	}
+	bench.finish();
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef BATCHBENCHMARK_H
+#define BATCHBENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+
+class PathBench;
+class Column;
+
+/*!
+ * \brief Times lines through a Path at various batch sizes and Plans
+ * 
+ * The Path parses a text Column and keeps a rolling window of it, as a
+ * typical logging Path would; see Inlet::setBatchSize().  The same Path is
+ * also run line by line, as one batch step per Module, and as compiled with
+ * the two fused (see Path::compilePlan()).
+ * 
+ * \ingroup benchmarks
+ */
+class BatchBenchmark : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void batch_data();
+	void batch();
+	void plan_data();
+	void plan();
+	
+private:
+	//! The text of each line's value
+	QVector<QByteArray> values;
+	
+	//! Append the Modules to \a bench and return the Inlet's Column
+	static Column *build(PathBench &bench);
+	
+	//! Send every line in #values through \a bench
+	void send(PathBench &bench, Column *value) const;
+};
+
+#endif // BATCHBENCHMARK_H
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "decimatebenchmark.h"
+#include <QtTest>
+#include <cmath>
+#include <random>
+#include "pathbench.h"
+#include "modules/decimatemodule.h"
+
+//! Lines sent per iteration
+static const int lines = 10000;
+
+//! Milliseconds between lines
+static const qint64 period = 10;
+
+void DecimateBenchmark::initTestCase() {
+	std::mt19937 rg(24);
+	std::normal_distribution<double> noise(0, 0.5);
+	values.resize(lines);
+	for (int i = 0; i < lines; ++i)
+		values[i] = 40 + 10 * std::sin(i / 700.0) + noise(rg);
+}
+
+void DecimateBenchmark::decimate_data() {
+	QTest::addColumn<QByteArray>("mode");
+	QTest::newRow("Average") << QByteArray("Average");
+	QTest::newRow("MinMax") << QByteArray("MinMax");
+	QTest::newRow("LTTB") << QByteArray("LTTB");
+}
+
+void DecimateBenchmark::decimate() {
+	QFETCH(QByteArray, mode);
+	PathBench bench("Decimate benchmark");
+	Column *value = bench.inlet()->addColumn("Value", Column::Double);
+	Column *time = bench.inlet()->addColumn("Time", Column::Timestamp);
+	QByteArray settings = "{\"Columns\": [\"Value\"], \"Time\": \"Time\", \"Seconds\": 1, \"Mode\": \"" + mode + "\"}";
+	bench.append<DecimateModule>("Decimate", settings.constData());
+	bench.append<BenchSink>("Sink");
+	bench.configure(256);
+	// Time keeps moving forward across iterations, so every bucket closes
+	qint64 t = 1500000000000LL;
+	QBENCHMARK {
+		for (int i = 0; i < lines; ++i) {
+			value->setDouble(values.at(i));
+			time->setTimestamp(t += period);
+			bench.line();
+		}
+		bench.finish();
+	}
+}
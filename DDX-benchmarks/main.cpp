@@ -0,0 +1,54 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include <QCoreApplication>
+#include <QtTest>
+#include "daemon_constants.h"
+#include "batchbenchmark.h"
+#include "numberformatbenchmark.h"
+#include "decimatebenchmark.h"
+#include "shardbenchmark.h"
+
+/*!
+ * \brief main
+ * \param argc argument count
+ * \param argv argument vector
+ * \return The number of failed benchmarks
+ * 
+ * Runs every benchmark in turn, passing each the QTestLib arguments.
+ */
+int main(int argc, char *argv[])
+{
+	QCoreApplication::setOrganizationName(APP_AUTHOR_FULL);
+	QCoreApplication::setOrganizationDomain(APP_AUTHOR_DOMAIN);
+	QCoreApplication::setApplicationName(APP_NAME_SHORT);
+	QCoreApplication::setApplicationVersion(VERSION_FULL_TEXT);
+	
+	QCoreApplication a(argc, argv);
+	
+	int failed = 0;
+	BatchBenchmark batch;
+	failed += QTest::qExec(&batch, argc, argv);
+	NumberFormatBenchmark numberFormat;
+	failed += QTest::qExec(&numberFormat, argc, argv);
+	DecimateBenchmark decimate;
+	failed += QTest::qExec(&decimate, argc, argv);
+	ShardBenchmark shard;
+	failed += QTest::qExec(&shard, argc, argv);
+	return failed;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "numberformatbenchmark.h"
+#include <QtTest>
+#include <QDateTime>
+#include <QLocale>
+#include <cmath>
+#include <random>
+#include "numberformat.h"
+
+//! Values formatted per iteration
+static const int count = 10000;
+
+void NumberFormatBenchmark::initTestCase() {
+	std::mt19937 rg(2);
+	std::uniform_real_distribution<double> mantissa(-10, 10);
+	std::uniform_int_distribution<int> exponent(-8, 8);
+	std::uniform_int_distribution<qint64> msecs(946684800000LL, 1893456000000LL);
+	doubles.resize(count);
+	timestamps.resize(count);
+	for (int i = 0; i < count; ++i) {
+		double d = mantissa(rg) * std::pow(10.0, exponent(rg));
+		// Readings rounded by an instrument are common too
+		if (i % 4 == 0) d = std::round(d * 100) / 100;
+		doubles[i] = i % 64 ? d : 0;
+		timestamps[i] = msecs(rg);
+	}
+}
+
+void NumberFormatBenchmark::formatDouble_data() {
+	addRows();
+}
+
+void NumberFormatBenchmark::formatDouble() {
+	QFETCH(bool, qt);
+	char out[NUMBER_FORMAT_MAX];
+	int total = 0;
+	QBENCHMARK {
+		for (int i = 0; i < count; ++i) {
+			if (qt) total += QByteArray::number(doubles.at(i), 'g', QLocale::FloatingPointShortest).size();
+			else total += NumberFormat::formatDouble(doubles.at(i), out);
+		}
+	}
+	QVERIFY(total > 0);
+}
+
+void NumberFormatBenchmark::formatFixed_data() {
+	addRows();
+}
+
+void NumberFormatBenchmark::formatFixed() {
+	QFETCH(bool, qt);
+	char out[NUMBER_FORMAT_MAX];
+	int total = 0;
+	QBENCHMARK {
+		for (int i = 0; i < count; ++i) {
+			if (qt) total += QByteArray::number(doubles.at(i), 'f', 3).size();
+			else total += NumberFormat::formatFixed(doubles.at(i), 3, out);
+		}
+	}
+	QVERIFY(total > 0);
+}
+
+void NumberFormatBenchmark::formatTimestamp_data() {
+	addRows();
+}
+
+void NumberFormatBenchmark::formatTimestamp() {
+	QFETCH(bool, qt);
+	char out[NUMBER_FORMAT_MAX];
+	int total = 0;
+	QBENCHMARK {
+		for (int i = 0; i < count; ++i) {
+			if (qt) total += QDateTime::fromMSecsSinceEpoch(timestamps.at(i), Qt::UTC)
+					.toString(Qt::ISODateWithMs).size();
+			else total += NumberFormat::formatTimestamp(timestamps.at(i), out);
+		}
+	}
+	QVERIFY(total > 0);
+}
+
+void NumberFormatBenchmark::addRows() {
+	QTest::addColumn<bool>("qt");
+	QTest::newRow("NumberFormat") << false;
+	QTest::newRow("Qt") << true;
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef NUMBERFORMATBENCHMARK_H
+#define NUMBERFORMATBENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+
+/*!
+ * \brief Times NumberFormat against the Qt functions it stands in for
+ * 
+ * Each benchmark runs with the row "NumberFormat" and with the row "Qt",
+ * which formats the same values with QByteArray::number() or QDateTime.
+ * 
+ * \ingroup benchmarks
+ */
+class NumberFormatBenchmark : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void formatDouble_data();
+	void formatDouble();
+	void formatFixed_data();
+	void formatFixed();
+	void formatTimestamp_data();
+	void formatTimestamp();
+	
+private:
+	//! Values spread over many magnitudes, with a few integers and zeros
+	QVector<double> doubles;
+	
+	//! Milliseconds since the UTC epoch from 2000 to 2030
+	QVector<qint64> timestamps;
+	
+	//! Add the "NumberFormat" and "Qt" rows
+	static void addRows();
+};
+
+#endif // NUMBERFORMATBENCHMARK_H
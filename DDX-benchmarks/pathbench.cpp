@@ -0,0 +1,101 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "pathbench.h"
+#include <QCoreApplication>
+#include <QThread>
+#include "daemon.h"
+#include "scheduler.h"
+#include "rapidjson_using.h"
+
+#if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+#error Qt version 5.10 or greater required
+#endif
+
+PathBench::PathBench(const QByteArray &name) {
+	p = new Path(daemon(), name, QByteArray());
+	// Paths move to the Daemon's Path thread, which has queued Path::init()
+	// before this; bring it back once that has run on the empty Path
+	QThread *caller = QThread::currentThread();
+	QMetaObject::invokeMethod(p, [this, caller]() {p->moveToThread(caller);}, Qt::BlockingQueuedConnection);
+	in = append<BenchInlet>("Inlet");
+}
+
+PathBench::~PathBench() {
+	p->cleanupDrained();
+	QCoreApplication::sendPostedEvents(p, QEvent::DeferredDelete);
+}
+
+void PathBench::configure(int batchSize) {
+	// Module::reconfigure() would look for an input to the Inlet
+	p->reconfigureFrom = 1;
+	p->applyReconfigure();
+	in->setBatchSize(batchSize);
+	p->state = Path::Running;
+}
+
+void PathBench::unfuse() {
+	if ( ! p->plan.valid) p->compilePlan(p->plan);
+	QVector<Path::PlanStep> steps;
+	for (int i = 0; i < p->plan.steps.size(); ++i) {
+		const Path::PlanStep &fused = p->plan.steps.at(i);
+		if ( ! fused.fused) {
+			steps.append(fused);
+			continue;
+		}
+		for (int j = fused.first; j < fused.end; ++j) {
+			Path::PlanStep step = fused;
+			step.run = &Path::runBatchStep;
+			step.first = j;
+			step.end = j + 1;
+			step.modules = QVector<Module*>(1, p->modules.at(j));
+			step.fused.clear();
+			// Only the first Module of a fused chain may have a filter
+			step.filtered = fused.filtered && j == fused.first;
+			step.feeds = fused.feeds && j == fused.end - 1;
+			step.drops = fused.drops && p->modules.at(j)->dropsLines();
+			steps.append(step);
+		}
+	}
+	p->plan.steps = steps;
+}
+
+void PathBench::repeat(int lines) {
+	p->batchFill = lines;
+	p->flushBatch();
+}
+
+Daemon *PathBench::daemon() {
+	// Its init() is queued on an event loop which never runs
+	static Daemon *d = new Daemon(QCoreApplication::instance());
+	return d;
+}
+
+void PathBench::setWorkers(int workers) {
+	Daemon *d = daemon();
+	delete d->scheduler;
+	d->scheduler = new Scheduler(workers);
+}
+
+void PathBench::init(Module *m, const char *settings) {
+	Document config;
+	config.Parse(settings);
+	p->appendModule(m);
+	m->init(config);
+	p->lastInitIndex = p->modules.size();
+}
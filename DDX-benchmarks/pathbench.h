@@ -0,0 +1,151 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef PATHBENCH_H
+#define PATHBENCH_H
+
+#include <QObject>
+#include <QByteArray>
+#include "path.h"
+#include "inlet.h"
+#include "module.h"
+
+//! \defgroup benchmarks Benchmarks
+
+class Daemon;
+
+/*!
+ * \brief An Inlet whose lines are filled and sent by a benchmark
+ * 
+ * \ingroup benchmarks
+ */
+class BenchInlet final : public Inlet
+{
+	Q_OBJECT
+public:
+	using Inlet::Inlet;
+	
+	//! Append a Column; call before PathBench::configure()
+	Column *addColumn(const QString &name, Column::Type type) {
+		return insertColumn(name, getOutputColumns()->size(), type);
+	}
+	
+	using Inlet::setBatchSize;
+	void start() override {}
+	void stop() override {}
+	void cleanup() override {}
+};
+
+/*!
+ * \brief A last Module which reads every Column but does nothing with them
+ * 
+ * Without it, the Columns of the Modules being measured would be dead and
+ * mostly skipped (see Column#live).
+ * 
+ * \ingroup benchmarks
+ */
+class BenchSink final : public Module
+{
+	Q_OBJECT
+public:
+	using Module::Module;
+	void process() override {}
+	void processBatch(int first, int count) override {(void) first; (void) count;}
+	bool processesBatches() const override {return true;}
+};
+
+/*!
+ * \brief A Path assembled from code and run on the calling thread
+ * 
+ * Stands in for a parsed scheme and the Path thread, so that benchmarks can
+ * time Path::process() and the Modules directly.  Append the Modules with
+ * append(), finish with a BenchSink, call configure() once, and then send
+ * lines by filling the Inlet's Columns and calling line().
+ * 
+ * \ingroup benchmarks
+ */
+class PathBench
+{
+public:
+	explicit PathBench(const QByteArray &name);
+	
+	~PathBench();
+	
+	BenchInlet *inlet() const {return in;}
+	
+	/*!
+	 * \brief Append a Module and initialize it
+	 * \param name Its name
+	 * \param settings Its settings as JSON
+	 * \return The Module, owned by the Path
+	 */
+	template<class M> M *append(const QByteArray &name, const char *settings = "{}");
+	
+	/*!
+	 * \brief Reconfigure every Module and start running
+	 * \param batchSize The Inlet's batch size; see Inlet::setBatchSize()
+	 */
+	void configure(int batchSize = 1);
+	
+	//! Send the Inlet's current values down the Path
+	void line() {p->process();}
+	
+	//! Run any lines still waiting in a batch
+	void finish() {p->flushBatch();}
+	
+	/*!
+	 * \brief Run the last batch again
+	 * \param lines The size of the batch, which must have been full
+	 * 
+	 * The batch's rows are still in the Inlet's Columns, so this times the
+	 * Modules alone.  Only for Paths whose Modules drop no lines.
+	 */
+	void repeat(int lines);
+	
+	/*!
+	 * \brief Run fused chains of Modules one Module at a time
+	 * 
+	 * Call after configure(); lasts until the Path's structure changes.
+	 */
+	void unfuse();
+	
+	//! The Daemon shared by every PathBench, which never starts its Network
+	static Daemon *daemon();
+	
+	/*!
+	 * \brief Replace the Daemon's Scheduler
+	 * \param workers Its number of worker threads; one per core if 0
+	 * 
+	 * No PathBench may be split into stages at the time.
+	 */
+	static void setWorkers(int workers);
+	
+private:
+	Path *p;
+	BenchInlet *in;
+	
+	void init(Module *m, const char *settings);
+};
+
+template<class M> M *PathBench::append(const QByteArray &name, const char *settings) {
+	M *m = new M(p, name);
+	init(m, settings);
+	return m;
+}
+
+#endif // PATHBENCH_H
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "shardbenchmark.h"
+#include <QtTest>
+#include <QThread>
+#include <random>
+#include "pathbench.h"
+#include "modules/parsemodule.h"
+
+//! Lines in the batch
+static const int lines = 65536;
+
+//! Text Columns parsed per line
+static const int columns = 8;
+
+void ShardBenchmark::initTestCase() {
+	std::mt19937 rg(9);
+	std::uniform_real_distribution<double> reading(-100, 1000);
+	values.resize(lines);
+	for (int i = 0; i < lines; ++i)
+		values[i] = QByteArray::number(reading(rg), 'f', 4);
+}
+
+void ShardBenchmark::cleanupTestCase() {
+	PathBench::setWorkers(0);
+}
+
+void ShardBenchmark::parse_data() {
+	QTest::addColumn<int>("workers");
+	QTest::newRow("1") << 1;
+	QTest::newRow("2") << 2;
+	int cores = QThread::idealThreadCount();
+	if (cores > 2) QTest::newRow(QByteArray::number(cores).constData()) << cores;
+}
+
+void ShardBenchmark::parse() {
+	QFETCH(int, workers);
+	PathBench::setWorkers(workers);
+	PathBench bench("Shard benchmark");
+	QVector<Column*> texts;
+	QByteArray settings = "{\"Columns\": [";
+	for (int k = 0; k < columns; ++k) {
+		QString name = QString("Value%1").arg(k);
+		texts.append(bench.inlet()->addColumn(name, Column::Text));
+		settings += (k ? ", \"" : "\"") + name.toUtf8() + "\"";
+	}
+	settings += "]}";
+	bench.append<ParseModule>("Parse", settings.constData());
+	bench.append<BenchSink>("Sink");
+	bench.configure(lines);
+	// The last line fills the batch and runs it once
+	for (int i = 0; i < lines; ++i) {
+		for (int k = 0; k < columns; ++k)
+			texts.at(k)->setText(values.at(i));
+		bench.line();
+	}
+	QBENCHMARK {
+		bench.repeat(lines);
+	}
+}
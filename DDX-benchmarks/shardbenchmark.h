@@ -0,0 +1,50 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef SHARDBENCHMARK_H
+#define SHARDBENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+
+/*!
+ * \brief Times a stateless Module sharded over more and more workers
+ * 
+ * A ParseModule converts eight text Columns of one large batch, as it would
+ * for a finite Inlet reading a file, with the Scheduler resized to one
+ * worker, two, and one per core (see Path::runStateless()).  With one worker
+ * the batch is not split at all.
+ * 
+ * \ingroup benchmarks
+ */
+class ShardBenchmark : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void parse_data();
+	void parse();
+	
+private:
+	//! The text of each line's values, the same for every Column
+	QVector<QByteArray> values;
+};
+
+#endif // SHARDBENCHMARK_H
@@ -0,0 +1,76 @@
+################################################################################
+##                         DATA DISPLAY APPLICATION X                         ##
+##                            2B TECHNOLOGIES, INC.                           ##
+##                                                                            ##
+## The DDX is free software: you can redistribute it and/or modify it under   ##
+## the terms of the GNU General Public License as published by the Free       ##
+## Software Foundation, either version 3 of the License, or (at your option)  ##
+## any later version.  The DDX is distributed in the hope that it will be     ##
+## useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     ##
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  ##
+## Public License for more details.  You should have received a copy of the   ##
+## GNU General Public License along with the DDX.  If not, see                ##
+## <http://www.gnu.org/licenses/>.                                            ##
+##                                                                            ##
+##  For more information about the DDX, check out the 2B website or GitHub:   ##
+##       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      ##
+################################################################################
+
+
+# The daemon's sources, shared with DDX-benchmarks; main.cpp is left out
+
+SOURCES += \
+    $$PWD/daemon.cpp \
+    $$PWD/inlet.cpp \
+    $$PWD/path.cpp \
+    $$PWD/pathstage.cpp \
+    $$PWD/pathclock.cpp \
+    $$PWD/scheduler.cpp \
+    $$PWD/sampler.cpp \
+    $$PWD/module.cpp \
+    $$PWD/data.cpp \
+    $$PWD/numberformat.cpp \
+    $$PWD/modules/examplemodule.cpp \
+    $$PWD/modules/module_register.cpp \
+    $$PWD/network.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/logger.cpp \
+    $$PWD/modules/exampleinlet.cpp \
+    $$PWD/modules/parsemodule.cpp \
+    $$PWD/modules/windowmodule.cpp \
+    $$PWD/modules/decimatemodule.cpp \
+    $$PWD/modules/deadbandmodule.cpp \
+    $$PWD/remdev.cpp \
+    $$PWD/netdev.cpp \
+    $$PWD/pathmanager.cpp
+
+HEADERS += \
+    $$PWD/../NoGit/private_constants.h \
+    $$PWD/daemon.h \
+    $$PWD/inlet.h \
+    $$PWD/path.h \
+    $$PWD/pathstage.h \
+    $$PWD/pathclock.h \
+    $$PWD/scheduler.h \
+    $$PWD/sampler.h \
+    $$PWD/module.h \
+    $$PWD/data.h \
+    $$PWD/numberformat.h \
+    $$PWD/modules/examplemodule.h \
+    $$PWD/network.h \
+    $$PWD/settings.h \
+    $$PWD/logger.h \
+    $$PWD/modules/exampleinlet.h \
+    $$PWD/modules/parsemodule.h \
+    $$PWD/modules/windowmodule.h \
+    $$PWD/modules/decimatemodule.h \
+    $$PWD/modules/deadbandmodule.h \
+    $$PWD/remdev.h \
+    $$PWD/netdev.h \
+    $$PWD/pathmanager.h \
+    $$PWD/rapidjson_using.h \
+    $$PWD/failqueue.h \
+    $$PWD/fusedchain.h \
+    $$PWD/daemon_constants.h
+
+RESOURCES += $$PWD/res/resources.qrc
@@ -40,40 +40,9 @@ CONFIG   -= app_bundle
 TEMPLATE = app
 
 
-SOURCES += main.cpp \
-    daemon.cpp \
-    inlet.cpp \
-    path.cpp \
-    module.cpp \
-    modules/examplemodule.cpp \
-    modules/module_register.cpp \
-    network.cpp \
-    settings.cpp \
-    logger.cpp \
-    modules/exampleinlet.cpp \
-    remdev.cpp \
-    netdev.cpp \
-    pathmanager.cpp
+SOURCES += main.cpp
 
-HEADERS += \
-    ../NoGit/private_constants.h \
-    daemon.h \
-    inlet.h \
-    path.h \
-    module.h \
-    data.h \
-    modules/examplemodule.h \
-    network.h \
-    settings.h \
-    logger.h \
-    modules/exampleinlet.h \
-    remdev.h \
-    netdev.h \
-    pathmanager.h \
-    rapidjson_using.h \
-    daemon_constants.h
-
-RESOURCES += res/resources.qrc
+include(DDX-daemon.pri)
 
 # Release build optimizations
 QMAKE_CFLAGS_RELEASE -= -O
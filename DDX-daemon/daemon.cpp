@@ -22,6 +22,8 @@
 #include "network.h"
 #include "settings.h"
 #include "logger.h"
+#include "scheduler.h"
+#include "sampler.h"
 #include <math.h>
 
 Daemon::Daemon(QCoreApplication *parent) : QObject(parent) {
@@ -32,9 +34,14 @@ Daemon::Daemon(QCoreApplication *parent) : QObject(parent) {
 	args = parent->arguments();
 	// Initialize other variables
 	sg = new Settings(this);
+	n = 0;  // Created by init()
 	unitManager = 0;
 	quitting = false;
 	utilityTimer = new QTimer(this);
+	scheduler = new Scheduler();
+	sampler = new Sampler();
+	pathThread = new QThread(this);
+	pathThread->start();
 	// TODO: Make this work with new syntax
 	connect(parent, SIGNAL(aboutToQuit()), this, SLOT(quit()));
 	QMetaObject::invokeMethod(this, "init", Qt::QueuedConnection);
@@ -44,6 +51,10 @@ Daemon::~Daemon() {
 	// TODO
 	if (unitManager) delete unitManager;
 	delete n;
+	pathThread->quit();
+	pathThread->wait();
+	delete sampler;
+	delete scheduler;
 }
 
 void Daemon::init() {
@@ -215,14 +226,9 @@ void Daemon::addPath(const QByteArray &name, int log) {
 	PathManager *um = getUnitManager();
 	QByteArray scheme = um->getPathScheme(name);
 	// TODO add error checking for scheme not found
-	QThread *t = new QThread(this);
+	// Path moves itself onto the Path thread and queues its own init()
 	Path *p = new Path(this, name, scheme);
 	paths.append(p);
-	p->moveToThread(t);
-	connect(t, &QThread::started, p, &Path::init);
-	connect(p, &Path::destroyed, t, &QThread::quit);
-	connect(t, &QThread::finished, t, &QThread::deleteLater);
-	t->start();
 	log +=2;
 	// TODO*/
 }
@@ -38,6 +38,8 @@ class Network;
 class Settings;
 class Logger;
 class RemDev;
+class Scheduler;
+class Sampler;
 
 //! \defgroup daemon Daemon
 //! \defgroup modules Daemon modules
@@ -48,8 +50,12 @@ class RemDev;
  * Instantiating this class will begin DDX operation.
  * 
  * ## Thread Structure
- * In addition to the Daemon's primary thread, every Path and Beacon gets a
- * thread to itself.
+ * In addition to the Daemon's primary thread, all Paths share one Path
+ * thread, which runs their Inlets, event handling and Modules, and one
+ * Scheduler whose pool of one worker per core runs the pipeline stages of
+ * split Paths and parallel work within them (see Path).  Inlets which
+ * poll instruments share one high-priority Sampler thread.  Every Beacon
+ * gets a thread to itself.
  * 
  * ## Utility Timers
  * The Daemon class manages a set of utility timers to trigger periodic maintenance
@@ -63,6 +69,7 @@ class RemDev;
 class Daemon : public QObject
 {
 	friend class Logger;
+	friend class PathBench;  // Resizes the Scheduler in DDX-benchmarks
 	Q_OBJECT
 public:
 	explicit Daemon(QCoreApplication *parent);
@@ -102,6 +109,15 @@ public:
 	
 	Settings *getSettings() const {return sg;}
 	
+	//! The thread every Path lives on
+	QThread *getPathThread() const {return pathThread;}
+	
+	//! The worker pool which runs Path stages
+	Scheduler *getScheduler() const {return scheduler;}
+	
+	//! The thread which samples polled instruments for Inlets
+	Sampler *getSampler() const {return sampler;}
+	
 	int countRemoteDevices() const {return devices.size();}
 	
 	/*!
@@ -217,6 +233,15 @@ private:
 	//! Utility timer
 	QTimer *utilityTimer;
 	
+	//! Shared by all Paths; owned by the Daemon
+	QThread *pathThread;
+	
+	//! Master pointer to Scheduler instance; must be manually freed
+	Scheduler *scheduler;
+	
+	//! Master pointer to Sampler instance; must be manually freed
+	Sampler *sampler;
+	
 	//! The time at which the two minute timer times out
 	qint64 twoMinuteTimeout;
 	
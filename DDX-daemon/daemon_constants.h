@@ -73,8 +73,38 @@
 
 // PLATFORM SPECIALIZATION
 
+// DATA
+//! Columns per DataDef segment; schema edits copy at most about twice this many pointers
+#define SCHEMA_SEGMENT_SIZE 64
+//! DataDef index changes tolerated before the shared index is rebuilt
+#define SCHEMA_INDEX_DELTA_MIN 32
+
 // BUFFERING
 #define MAX_SOCKET_BUFFER_SIZE		104857600  // 104857600 = 100mb
+//! Maximum items an Inlet drains from one FailQueue before yielding to the event loop
+#define INLET_DRAIN_BATCH 1024
+//! Maximum lines a finite Inlet reads before yielding to the event loop (see Inlet::readLine())
+#define FINITE_DRAIN_LINES 4096
+//! Lines per chunk when a finite Inlet reads chunks in parallel (see Inlet::readsChunks())
+#define FINITE_CHUNK_LINES 8192
+//! Maximum timeouts a PathClock fires before yielding to the event loop
+#define CLOCK_BURST_TIMEOUTS 1024
+//! Power-of-two microsecond buckets in each Sampler jitter histogram
+#define SAMPLER_JITTER_BUCKETS 16
+//! Points kept per convex hull by DecimateModule before thinning
+#define DECIMATE_MAX_HULL 256
+//! Maximum batches in flight across a Path's pipeline stages before further lines are held
+#define PIPELINE_QUEUE_DEPTH 16
+//! Maximum lines held on the Path thread while its stages catch up; later lines are dropped
+#define PIPELINE_BACKLOG_LINES 65536
+//! Lines timed before automatic stage boundaries are chosen (see Path::setAutoStages())
+#define PIPELINE_PROFILE_LINES 4096
+//! Fewest lines of a batch given to each thread running stateless Modules
+#define SHARD_MIN_LINES 512
+
+// SCHEDULING
+//! Tasks a Scheduler worker runs from one Strand before moving on to others
+#define SCHEDULER_STRAND_BUDGET 64
 
 // MISCELLANEOUS
 #define VERSION_COMPARE_FAILED 10
@@ -0,0 +1,453 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "data.h"
+#include "daemon_constants.h"
+#include "numberformat.h"
+#include <QStringList>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+
+//! Guards the ColumnNames intern table
+static QReadWriteLock columnNamesLock;
+
+//! Case-folded names mapped to their handles
+static QHash<QString, ColumnHandle> columnHandles;
+
+//! Original spellings indexed by handle
+static QStringList columnNames;
+
+//! Source of DataDef versions
+static QAtomicInteger<quint64> schemaVersions;
+
+ColumnHandle ColumnNames::intern(const QString &name) {
+	QString folded = name.toCaseFolded();
+	columnNamesLock.lockForRead();
+	ColumnHandle h = columnHandles.value(folded, -1);
+	columnNamesLock.unlock();
+	if (h >= 0) return h;
+	columnNamesLock.lockForWrite();
+	// Another thread may have interned it between locks
+	h = columnHandles.value(folded, -1);
+	if (h < 0) {
+		h = columnNames.size();
+		columnNames.append(name);
+		columnHandles.insert(folded, h);
+	}
+	columnNamesLock.unlock();
+	return h;
+}
+
+ColumnHandle ColumnNames::find(const QString &name) {
+	QString folded = name.toCaseFolded();
+	columnNamesLock.lockForRead();
+	ColumnHandle h = columnHandles.value(folded, -1);
+	columnNamesLock.unlock();
+	return h;
+}
+
+QString ColumnNames::name(ColumnHandle h) {
+	columnNamesLock.lockForRead();
+	QString n = columnNames.value(h);
+	columnNamesLock.unlock();
+	return n;
+}
+
+ColumnPool::~ColumnPool() {
+	qDeleteAll(idle);
+}
+
+Column* ColumnPool::acquire(ColumnHandle handle, const QString &name, Module *parent, Column::Type type) {
+	QMutexLocker l(&lock);
+	if (idle.isEmpty()) return new Column(handle, name, parent, type);
+	Column *c = idle.last();
+	idle.removeLast();
+	c->reset(handle, name, parent, type);
+	return c;
+}
+
+void ColumnPool::release(Column *c) {
+	QMutexLocker l(&lock);
+	idle.append(c);
+}
+
+void Column::setString(const QByteArray &s) {
+	int i = dict.indexOf(s);
+	if (i < 0) {
+		i = dict.size();
+		dict.append(s);
+	}
+	v.i = i;
+	stale = true;
+}
+
+double Column::toDouble(bool *ok) const {
+	if (ok) *ok = true;
+	switch (t) {
+	case Double: return v.d;
+	case Int64:
+	case Timestamp: return (double) v.i;
+	case Bool: return v.b ? 1 : 0;
+	case Dictionary: return dict.value((int) v.i).toDouble(ok);
+	default: return c.toDouble(ok);
+	}
+}
+
+qint64 Column::toInt(bool *ok) const {
+	if (ok) *ok = true;
+	switch (t) {
+	case Double: return (qint64) v.d;
+	case Int64:
+	case Timestamp: return v.i;
+	case Bool: return v.b ? 1 : 0;
+	case Dictionary: return dict.value((int) v.i).toLongLong(ok);
+	default: return c.toLongLong(ok);
+	}
+}
+
+double Column::rowDouble(int row, bool *ok) const {
+	if (ok) *ok = true;
+	switch (t) {
+	case Double: return rows.at(row).d;
+	case Int64:
+	case Timestamp: return (double) rows.at(row).i;
+	case Bool: return rows.at(row).b ? 1 : 0;
+	case Dictionary: return dict.value((int) rows.at(row).i).toDouble(ok);
+	default: return rowText.at(row).toDouble(ok);
+	}
+}
+
+qint64 Column::rowInt(int row, bool *ok) const {
+	if (ok) *ok = true;
+	switch (t) {
+	case Double: return (qint64) rows.at(row).d;
+	case Int64:
+	case Timestamp: return rows.at(row).i;
+	case Bool: return rows.at(row).b ? 1 : 0;
+	case Dictionary: return dict.value((int) rows.at(row).i).toLongLong(ok);
+	default: return rowText.at(row).toLongLong(ok);
+	}
+}
+
+void Column::format() {
+	// Written in place so that formatting reuses the capacity of c
+	char s[NUMBER_FORMAT_MAX];
+	switch (t) {
+	case Double:
+		if (decimals < 0) setText(s, NumberFormat::formatDouble(v.d, s));
+		else setText(s, NumberFormat::formatFixed(v.d, decimals, s));
+		break;
+	case Int64:
+		setText(s, NumberFormat::formatInt(v.i, s));
+		break;
+	case Timestamp:
+		setText(s, NumberFormat::formatTimestamp(v.i, s));
+		break;
+	case Bool:
+		c = v.b ? "true" : "false";
+		break;
+	case Dictionary:
+		c = dict.value((int) v.i);
+		break;
+	default:
+		break;
+	}
+	stale = false;
+}
+
+Column* DataDef::at(int i) const {
+	int s = segmentOf(i);
+	return d->segs.at(s)->c.at(i);
+}
+
+Column* DataDef::find(ColumnHandle h) const {
+	if ( ! d) return 0;
+	ColumnIndex::const_iterator it = d->delta.constFind(h);
+	if (it != d->delta.constEnd()) return it.value();
+	return d->base ? d->base->map.value(h, 0) : 0;
+}
+
+int DataDef::indexOf(const Column *c) const {
+	if ( ! d) return -1;
+	for (int s = 0; s < d->segs.size(); ++s) {
+		int k = d->segs.at(s)->c.indexOf((Column*) c);
+		if (k >= 0) return d->starts.at(s) + k;
+	}
+	return -1;
+}
+
+void DataDef::insert(int i, Column *c) {
+	detach();
+	if (d->segs.isEmpty()) {
+		d->segs.append(QExplicitlySharedDataPointer<Segment>(new Segment));
+		d->starts.append(0);
+	}
+	if (i < 0) i = 0;
+	if (i > d->size) i = d->size;
+	int s = segmentOf(i);
+	Segment *seg = editSegment(s);
+	seg->c.insert(i, c);
+	for (int k = s + 1; k < d->starts.size(); ++k)
+		d->starts[k]++;
+	d->size++;
+	// Split oversized segments so later edits stay cheap
+	if (seg->c.size() > 2 * SCHEMA_SEGMENT_SIZE) {
+		int half = seg->c.size() / 2;
+		Segment *tail = new Segment;
+		tail->c = seg->c.mid(half);
+		seg->c.resize(half);
+		d->segs.insert(s + 1, QExplicitlySharedDataPointer<Segment>(tail));
+		d->starts.insert(s + 1, d->starts.at(s) + half);
+	}
+	d->delta.insert(c->h, c);
+	compactIndex();
+}
+
+bool DataDef::removeOne(const Column *c) {
+	if ( ! d || ! c) return false;
+	for (int s = 0; s < d->segs.size(); ++s) {
+		int k = d->segs.at(s)->c.indexOf((Column*) c);
+		if (k < 0) continue;
+		detach();
+		Segment *seg = editSegment(s);
+		seg->c.remove(k);
+		for (int j = s + 1; j < d->starts.size(); ++j)
+			d->starts[j]--;
+		if (seg->c.isEmpty() && d->segs.size() > 1) {
+			d->segs.remove(s);
+			d->starts.remove(s);
+		}
+		d->size--;
+		if (find(c->h) == c) {
+			if (d->base && d->base->map.contains(c->h)) d->delta.insert(c->h, 0);
+			else d->delta.remove(c->h);
+			compactIndex();
+		}
+		return true;
+	}
+	return false;
+}
+
+void DataDef::swap(int i, int j) {
+	Column *a = at(i);
+	Column *b = at(j);
+	detach();
+	set(i, b);
+	set(j, a);
+}
+
+void DataDef::detach() {
+	if ( ! d) d = new Data;
+	else d.detach();
+	d->version = schemaVersions.fetchAndAddRelaxed(1) + 1;
+}
+
+int DataDef::segmentOf(int &i) const {
+	const QVector<int> &starts = d->starts;
+	int lo = 0;
+	int hi = starts.size() - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (starts.at(mid) <= i) lo = mid;
+		else hi = mid - 1;
+	}
+	i -= starts.at(lo);
+	return lo;
+}
+
+DataDef::Segment* DataDef::editSegment(int s) {
+	d->segs[s].detach();
+	return d->segs[s].data();
+}
+
+void DataDef::set(int i, Column *c) {
+	int s = segmentOf(i);
+	editSegment(s)->c[i] = c;
+}
+
+void DataDef::compactIndex() {
+	if (d->delta.size() <= SCHEMA_INDEX_DELTA_MIN || d->delta.size() * 8 <= d->size) return;
+	Index *x = new Index;
+	x->map.reserve(d->size);
+	for (const_iterator it = begin(); it != end(); ++it)
+		x->map.insert((*it)->h, *it);
+	d->base = x;
+	d->delta.clear();
+}
+
+ColumnMirror::~ColumnMirror() {
+	QHash<ColumnHandle, Column*>::const_iterator it;
+	for (it = clones.constBegin(); it != clones.constEnd(); ++it)
+		pool->release(it.value());
+}
+
+void ColumnMirror::setSchema(const QVector<Spec> &schema) {
+	QHash<ColumnHandle, Column*> kept;
+	DataDef d;
+	for (int i = 0; i < schema.size(); ++i) {
+		const Spec &s = schema.at(i);
+		Column *c = clones.take(s.h);
+		if (c && c->t != s.t) {
+			pool->release(c);
+			c = 0;
+		}
+		if ( ! c) c = pool->acquire(s.h, ColumnNames::name(s.h), 0, s.t);
+		kept.insert(s.h, c);
+		d.append(c);
+	}
+	// Anything left was removed upstream
+	QHash<ColumnHandle, Column*>::const_iterator it;
+	for (it = clones.constBegin(); it != clones.constEnd(); ++it)
+		pool->release(it.value());
+	clones = kept;
+	mirror = d;
+}
+
+void ColumnMirror::follow(const DataDef *from) {
+	if (from->version() == followed) return;
+	followed = from->version();
+	setSchema(describe(from));
+}
+
+void ColumnMirror::copyValues(const DataDef *from) {
+	DataDef::const_iterator src = from->begin(), dst = mirror.begin();
+	for (; src != from->end(); ++src, ++dst) {
+		Column *s = *src, *d = *dst;
+		d->v = s->v;
+		d->c = s->c;
+		d->stale = s->stale;
+		d->decimals = s->decimals;
+		if (s->t == Column::Dictionary) d->dict = s->dict;
+	}
+}
+
+void ColumnMirror::copyRows(const DataDef *from) {
+	DataDef::const_iterator src = from->begin(), dst = mirror.begin();
+	for (; src != from->end(); ++src, ++dst) {
+		(*dst)->rows = (*src)->rows;
+		(*dst)->rowText = (*src)->rowText;
+		(*dst)->dict = (*src)->dict;
+		(*dst)->decimals = (*src)->decimals;
+	}
+}
+
+QVector<ColumnMirror::Spec> ColumnMirror::describe(const DataDef *from) {
+	QVector<Spec> schema;
+	schema.reserve(from->size());
+	for (DataDef::const_iterator it = from->begin(); it != from->end(); ++it) {
+		Spec s = {(*it)->h, (*it)->t};
+		schema.append(s);
+	}
+	return schema;
+}
+
+void LineFilter::setPredicates(const QVector<LinePredicate> &keep) {
+	this->keep = keep;
+	tests.resize(0);
+	bound = 0;
+}
+
+bool LineFilter::dependsOnOrder() const {
+	for (int i = 0; i < keep.size(); ++i)
+		if (keep.at(i).kind == LinePredicate::Changed) return true;
+	return false;
+}
+
+void LineFilter::bind(const DataDef *columns) {
+	if (columns == bound && columns->version() == boundVersion && tests.size() == keep.size()) return;
+	bound = columns;
+	boundVersion = columns->version();
+	if (tests.size() != keep.size()) {
+		tests.resize(keep.size());
+		for (int i = 0; i < tests.size(); ++i) {
+			tests[i].c = 0;
+			tests[i].seen = false;
+		}
+	}
+	for (int i = 0; i < keep.size(); ++i) {
+		Column *c = columns->find(keep.at(i).h);
+		// A different Column has nothing in common with the last one kept
+		if (c != tests.at(i).c) tests[i].seen = false;
+		tests[i].c = c;
+	}
+}
+
+bool LineFilter::test(int row) {
+	static const QByteArray none;
+	bool changed = false;
+	bool anyChanged = false;
+	for (int i = 0; i < keep.size(); ++i) {
+		const LinePredicate &p = keep.at(i);
+		Test &t = tests[i];
+		const Column *c = t.c;
+		if ( ! c) continue;
+		Column::Value v = row < 0 ? c->v : (c->isNative() ? c->rows.at(row) : Column::Value());
+		const QByteArray *s = 0;
+		double num = 0;
+		switch (c->t) {
+		case Column::Double: num = v.d; break;
+		case Column::Int64:
+		case Column::Timestamp: num = (double) v.i; break;
+		case Column::Bool: num = v.b ? 1 : 0; break;
+		case Column::Dictionary:
+			num = (double) v.i;
+			s = (v.i >= 0 && v.i < c->dict.size()) ? &c->dict.at(v.i) : &none;
+			break;
+		default:
+			s = row < 0 ? &c->c : &c->rowText.at(row);
+			if (p.kind == LinePredicate::Range) {
+				// Malformed text passes no range, just as ParseModule makes it NaN
+				bool ok;
+				num = s->toDouble(&ok);
+				if ( ! ok) return false;
+			}
+		}
+		switch (p.kind) {
+		case LinePredicate::Range:
+			if ( ! (num >= p.min && num <= p.max)) return false;
+			break;
+		case LinePredicate::Equal:
+			if (s ? *s != p.text : num != p.min) return false;
+			break;
+		case LinePredicate::Changed:
+			anyChanged = true;
+			if ( ! t.seen) changed = true;
+			else if (s) changed |= (*s != t.lastText);
+			else if (c->t == Column::Double) changed |= (v.d != t.last.d);
+			else if (c->t == Column::Bool) changed |= (v.b != t.last.b);
+			else changed |= (v.i != t.last.i);
+			break;
+		}
+	}
+	if ( ! anyChanged) return true;
+	if ( ! changed) return false;
+	// Remember the kept line for the next comparison
+	for (int i = 0; i < keep.size(); ++i) {
+		if (keep.at(i).kind != LinePredicate::Changed || ! tests.at(i).c) continue;
+		Test &t = tests[i];
+		const Column *c = t.c;
+		t.seen = true;
+		if (c->t == Column::Dictionary) {
+			t.last = row < 0 ? c->v : c->rows.at(row);
+			t.lastText = (t.last.i >= 0 && t.last.i < c->dict.size()) ? c->dict.at(t.last.i) : none;
+		}
+		else if (c->isNative()) t.last = row < 0 ? c->v : c->rows.at(row);
+		else t.lastText = row < 0 ? c->c : c->rowText.at(row);
+	}
+	return true;
+}
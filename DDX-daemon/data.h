@@ -22,6 +22,11 @@
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QVector>
+#include <QHash>
+#include <QSharedData>
+#include <QMutex>
+#include <cstring>
 
 /*!
  * \file data.h
@@ -32,30 +37,578 @@
 
 class Module;
 
+/*!
+ * \brief A stable, process-wide identifier for a case-insensitive column name
+ * 
+ * Handles are obtained from ColumnNames and never change for the lifetime of
+ * the Daemon, so Modules can look them up once in init() and keep using them
+ * across any number of reconfigures.
+ */
+typedef int ColumnHandle;
+
+/*!
+ * \brief Global intern table of case-folded Column names
+ * 
+ * Every Column name is case-folded and assigned a ColumnHandle the first time
+ * it is seen, so that comparing names is an integer comparison and finding a
+ * Column is a hash lookup.  This class is thread-safe.
+ */
+class ColumnNames {
+public:
+	
+	/*!
+	 * \brief Get the handle for a name, assigning one if necessary
+	 * \param name The case-insensitive column name
+	 * \return The name's handle
+	 */
+	static ColumnHandle intern(const QString &name);
+	
+	/*!
+	 * \brief Get the handle for a name without assigning one
+	 * \param name The case-insensitive column name
+	 * \return The name's handle, or -1 if the name has never been interned
+	 */
+	static ColumnHandle find(const QString &name);
+	
+	/*!
+	 * \brief Get the name of a handle
+	 * \param h The handle
+	 * \return The spelling with which the handle was first interned
+	 */
+	static QString name(ColumnHandle h);
+};
+
 /*!
  * \brief Stores the contents of and metadata about a column as it resides in a stream
+ * 
+ * ## Typed Values
+ * A Column carries its value in its native form, selected by #t when the
+ * Column is inserted.  Numeric, timestamp, boolean, and dictionary columns
+ * keep their value in #v and only produce a text form when one is requested
+ * with text(), so that a reading which is never displayed or written out is
+ * never formatted.  Text and Bytes columns keep their value in #c as before.
+ * 
+ * Producers should use the setter which matches the Column's type.  Consumers
+ * which need a number should use toDouble() or toInt(), which read native
+ * values directly and only fall back to parsing for text columns.
  */
 struct Column {
-	QByteArray c;  //!< The column's actual data buffer
+	
+	//! The native representation of a Column's value
+	enum Type {
+		Text,  //!< Free-form text held in #c
+		Bytes,  //!< Raw binary data held in #c
+		Double,  //!< A double held in Value::d
+		Int64,  //!< A 64-bit signed integer held in Value::i
+		Timestamp,  //!< Milliseconds since the UTC epoch held in Value::i
+		Bool,  //!< A boolean held in Value::b
+		Dictionary  //!< A repeating string held as an index into #dict in Value::i
+	};
+	
+	//! Storage for native values; the active member is determined by #t
+	union Value {
+		double d;
+		qint64 i;
+		bool b;
+	};
+	
+	QByteArray c;  //!< The column's text buffer (canonical for Text and Bytes)
 	QString n; //!< The name and main identifier of the column as reported by its parent
+	ColumnHandle h;  //!< The interned handle of #n
 	Module *p;  //!< A pointer to the column's parent Module
+	Type t;  //!< The column's value type (not editable after insertion)
+	Value v;  //!< The column's native value for all non-text types
+	bool stale;  //!< Whether #c is out of date with respect to #v
+	bool live;  //!< Whether any Module may read the Column (see Module::insertColumn())
+	int decimals;  //!< Decimal places of the text form of a Double, or -1 for the shortest exact form
+	
+	/*!
+	 * \brief Strings seen by a Dictionary column, indexed by Value::i
+	 * 
+	 * Dictionary columns are intended for low-cardinality strings such as
+	 * status flags and units.  Entries are never removed while the Column
+	 * exists.
+	 */
+	QList<QByteArray> dict;
 	
-	Column(QString name, Module *parent) {
+	/*!
+	 * \brief Native values for each line of the current batch
+	 * 
+	 * Only used when a Path is processing batches; see Module::processBatch().
+	 * Row storage persists between batches so that its capacity is reused.
+	 */
+	QVector<Value> rows;
+	
+	//! Text values for each line of the current batch (Text and Bytes only)
+	QVector<QByteArray> rowText;
+	
+	Column(QString name, Module *parent, Type type = Text) {
+		reset(ColumnNames::intern(name), name, parent, type);
+	}
+	
+	//! Construct a Column whose name was already interned as \a handle
+	Column(ColumnHandle handle, const QString &name, Module *parent, Type type) {
+		reset(handle, name, parent, type);
+	}
+	
+	/*!
+	 * \brief Reinitialize a recycled Column
+	 * \param handle The interned handle of \a name
+	 * \param name The Column's name
+	 * \param parent The Column's new parent
+	 * \param type The Column's value type
+	 * 
+	 * Buffer and row capacity is kept so that a recycled Column allocates
+	 * nothing until it holds more data than it did before.  See ColumnPool.
+	 */
+	void reset(ColumnHandle handle, const QString &name, Module *parent, Type type) {
 		n = name;
+		h = handle;
 		p = parent;
+		t = type;
+		v.i = 0;
+		c.resize(0);
+		dict.clear();
+		rows.resize(0);
+		rowText.resize(0);
+		stale = (type != Text && type != Bytes);
+		live = true;
+		decimals = -1;
+	}
+	
+	/*!
+	 * \brief Get the column's text buffer
+	 * \return A pointer to #c
+	 * 
+	 * This is the legacy text interface.  For non-text columns, the text form is
+	 * brought up to date before returning, so the buffer is safe to read but
+	 * writes to it will not be reflected in #v.
+	 */
+	QByteArray* buffer() {text(); return &c;}
+	
+	/*!
+	 * \brief Get the column's value as text
+	 * \return The text form, formatted now if it was stale
+	 */
+	const QByteArray& text() {
+		if (stale) format();
+		return c;
 	}
 	
-	QByteArray* buffer() {return &c;}
+	//! Whether the Column holds a native value rather than text
+	bool isNative() const {return t != Text && t != Bytes;}
+	
+	void setText(const QByteArray &text) {c = text;}
+	
+	//! Set the text from a buffer, reusing the capacity of #c; see NumberFormat
+	void setText(const char *text, int length) {
+		c.resize(length);
+		memcpy(c.data(), text, length);
+	}
+	
+	/*!
+	 * \brief Format a Double column's text to a fixed number of decimal places
+	 * \param places From 0 to 17, or -1 (the default) for the shortest exact form
+	 */
+	void setDecimals(int places) {decimals = places; stale = isNative();}
+	void setDouble(double d) {v.d = d; stale = true;}
+	void setInt(qint64 i) {v.i = i; stale = true;}
+	void setTimestamp(qint64 msecs) {v.i = msecs; stale = true;}
+	void setBool(bool b) {v.b = b; stale = true;}
+	
+	/*!
+	 * \brief Set the value of a Dictionary column
+	 * \param s The string, which is added to #dict if it is new
+	 */
+	void setString(const QByteArray &s);
+	
+	/*!
+	 * \brief Read the value as a double
+	 * \param ok Set to whether the conversion succeeded (optional)
+	 * \return The value, parsing #c only if this is a text column
+	 */
+	double toDouble(bool *ok = 0) const;
+	
+	/*!
+	 * \brief Read the value as an integer
+	 * \param ok Set to whether the conversion succeeded (optional)
+	 * \return The value, parsing #c only if this is a text column
+	 */
+	qint64 toInt(bool *ok = 0) const;
+	
+	/*!
+	 * \brief Read line \a row of the current batch as a double
+	 * \param ok Set to whether the conversion succeeded (optional)
+	 * \return The value, converted the same way as by toDouble()
+	 */
+	double rowDouble(int row, bool *ok = 0) const;
+	
+	//! Read line \a row of the current batch as an integer; see rowDouble()
+	qint64 rowInt(int row, bool *ok = 0) const;
+	
+	//! Ensure row storage exists for a batch of \a lines lines
+	void resizeRows(int lines) {
+		if (isNative()) {if (rows.size() < lines) rows.resize(lines);}
+		else if (rowText.size() < lines) rowText.resize(lines);
+	}
+	
+	//! Give the Column sole ownership of its row storage
+	void detachRows() {
+		rows.detach();
+		rowText.detach();
+	}
+	
+	//! Make line \a row of the current batch the Column's value
+	void load(int row) {
+		if (isNative()) {
+			v = rows.at(row);
+			stale = true;
+		}
+		else c = rowText.at(row);
+	}
+	
+	//! Save the Column's value as line \a row of the current batch
+	void store(int row) {
+		if (isNative()) rows[row] = v;
+		else rowText[row] = c;
+	}
+	
+	//! Copy line \a from of the current batch over line \a to
+	void moveRow(int from, int to) {
+		if (isNative()) rows[to] = rows.at(from);
+		else rowText[to] = rowText.at(from);
+	}
+	
+private:
+	//! Regenerate #c from #v
+	void format();
+};
+
+/*!
+ * \brief Recycles Column instances for a Path
+ * 
+ * Modules insert and destroy their Columns on every reconfigure, which for
+ * Inlets that change structure often would otherwise mean a steady stream of
+ * small allocations over a Daemon's lifetime.  Each Path owns one pool;
+ * Module::insertColumn() takes Columns from it and reconfigure returns them,
+ * so once a Path has seen its largest structure it stops allocating Columns.
+ * 
+ * Pools are shared by all pipeline stages of a Path and are thread-safe.
+ */
+class ColumnPool {
+public:
+	
+	ColumnPool() {}
+	
+	//! Deletes all idle Columns; Columns still in use must be released first
+	~ColumnPool();
+	
+	/*!
+	 * \brief Get a Column, recycling an idle one if possible
+	 * \return An initialized Column owned by the caller until released
+	 * 
+	 * See Column::reset() for parameters.
+	 */
+	Column* acquire(ColumnHandle handle, const QString &name, Module *parent, Column::Type type);
+	
+	/*!
+	 * \brief Return a Column to the pool
+	 * \param c The Column, which must not be used by the caller afterward
+	 */
+	void release(Column *c);
+	
+	//! The number of idle Columns available for reuse
+	int idleCount() const {return idle.size();}
+	
+private:
+	Q_DISABLE_COPY(ColumnPool)
+	
+	//! Pipeline stages of one Path reconfigure concurrently
+	QMutex lock;
+	
+	//! Released Columns waiting to be reused
+	QVector<Column*> idle;
 };
 
 /*!
- * \brief DataDef struct
+ * \brief Maps handles to Columns for constant-time lookup
+ */
+typedef QHash<ColumnHandle, Column*> ColumnIndex;
+
+/*!
+ * \brief DataDef class
  * 
  * An ordered representation of Columns, which can model the format of data at
  * any point in the stream.
+ * 
+ * ## Structural Sharing
+ * A DataDef is a handle to an immutable, reference-counted schema version.
+ * Copying one is a pointer copy, so a Module which does not change the
+ * structure passes its upstream schema through outright.  Editing a DataDef
+ * (insert(), removeOne(), swap()) produces a new version for that handle
+ * only.  Columns are stored in fixed-capacity segments and the handle index
+ * is a shared base plus a small delta, so an edit copies one segment and the
+ * segment table rather than the whole schema.  Published versions are never
+ * modified and may be read from any thread.
  */
-typedef QList<Column*> DataDef;
+class DataDef {
+	
+	//! A run of consecutive Columns shared between schema versions
+	struct Segment : public QSharedData {
+		QVector<Column*> c;
+	};
+	
+	//! A handle index shared between schema versions
+	struct Index : public QSharedData {
+		ColumnIndex map;
+	};
+	
+	//! One schema version
+	struct Data : public QSharedData {
+		Data() : size(0), version(0) {}
+		QVector<QExplicitlySharedDataPointer<Segment> > segs;  //!< Column segments in order
+		QVector<int> starts;  //!< Index of the first Column in each segment
+		int size;  //!< Total number of Columns
+		QExplicitlySharedDataPointer<Index> base;  //!< Index as of the last compaction
+		ColumnIndex delta;  //!< Index changes since #base; null values mark removals
+		quint64 version;  //!< Unique identifier of this version
+	};
+	
+public:
+	
+	//! Iterates over Columns in order without indexing each one
+	class const_iterator {
+	public:
+		const_iterator() : d(0), s(0), k(0) {}
+		const_iterator(const Data *d, int s, int k) : d(d), s(s), k(k) {}
+		Column* operator*() const {return d->segs.at(s)->c.at(k);}
+		const_iterator& operator++() {
+			if (++k >= d->segs.at(s)->c.size()) {
+				++s;
+				k = 0;
+			}
+			return *this;
+		}
+		bool operator==(const const_iterator &o) const {return s == o.s && k == o.k;}
+		bool operator!=(const const_iterator &o) const {return s != o.s || k != o.k;}
+	private:
+		const Data *d;
+		int s, k;
+	};
+	
+	DataDef() {}
+	
+	int size() const {return d ? d->size : 0;}
+	
+	bool isEmpty() const {return size() == 0;}
+	
+	//! Get the Column at position \a i, which must be valid
+	Column* at(int i) const;
+	
+	/*!
+	 * \brief Find a Column by handle
+	 * \param h The handle
+	 * \return The Column or 0 if there is none
+	 */
+	Column* find(ColumnHandle h) const;
+	
+	//! Get the position of \a c, or -1 if it is not present (linear)
+	int indexOf(const Column *c) const;
+	
+	/*!
+	 * \brief Insert a Column
+	 * \param i The position, which is clamped to the valid range
+	 * \param c The Column
+	 */
+	void insert(int i, Column *c);
+	
+	void append(Column *c) {insert(size(), c);}
+	
+	/*!
+	 * \brief Remove a Column
+	 * \param c The Column
+	 * \return Whether it was present
+	 */
+	bool removeOne(const Column *c);
+	
+	//! Exchange the Columns at positions \a i and \a j
+	void swap(int i, int j);
+	
+	//! Whether both handles refer to the same schema version
+	bool isSharedWith(const DataDef &o) const {return d == o.d;}
+	
+	/*!
+	 * \brief Get the schema version
+	 * \return A process-wide unique identifier which changes on every edit, or
+	 * 0 for an empty DataDef which has never been edited
+	 */
+	quint64 version() const {return d ? d->version : 0;}
+	
+	const_iterator begin() const {return isEmpty() ? end() : const_iterator(d.data(), 0, 0);}
+	
+	const_iterator end() const {return const_iterator(d.data(), d ? d->segs.size() : 0, 0);}
+	
+private:
+	QExplicitlySharedDataPointer<Data> d;
+	
+	//! Make #d exclusive to this handle, creating it if necessary, and give it a new version
+	void detach();
+	
+	//! Find the segment holding position \a i and make \a i relative to it
+	int segmentOf(int &i) const;
+	
+	//! Get segment \a s for writing, copying it if it is shared
+	Segment* editSegment(int s);
+	
+	//! Replace the Column at position \a i
+	void set(int i, Column *c);
+	
+	//! Rebuild the index base if the delta has grown too large
+	void compactIndex();
+};
+
+/*!
+ * \brief A private copy of another DataDef's Columns
+ * 
+ * Modules pass Columns downstream by modifying them in place, so two Modules
+ * reading the same upstream output would see each other's changes.  A mirror
+ * gives a reader its own Columns with the same names and types, whose values
+ * are copied over once the upstream Module has run.  Copies share text and
+ * row storage until either side writes.
+ * 
+ * Used for the branches of a Path and for its pipeline stages.
+ */
+class ColumnMirror {
+public:
+	
+	//! The name and type of a mirrored Column
+	struct Spec {
+		ColumnHandle h;
+		Column::Type t;
+	};
+	
+	//! \param pool Where mirrored Columns are taken from and returned to
+	explicit ColumnMirror(ColumnPool *pool) : pool(pool), followed(0) {}
+	
+	//! Returns all mirrored Columns to the pool
+	~ColumnMirror();
+	
+	//! The mirrored Columns
+	const DataDef* columns() const {return &mirror;}
+	
+	/*!
+	 * \brief Rebuild the mirror
+	 * \param schema The names and types to mirror, in order
+	 * 
+	 * Columns whose name and type are unchanged are kept, so Modules which
+	 * declared they do not use the changed Columns are not reconfigured (see
+	 * Module::declareColumns()).
+	 */
+	void setSchema(const QVector<Spec> &schema);
+	
+	//! Rebuild the mirror if \a from has changed since the last call
+	void follow(const DataDef *from);
+	
+	//! Copy the current line's values and formatting from \a from, which must be followed
+	void copyValues(const DataDef *from);
+	
+	//! Copy the current batch's rows and formatting from \a from, which must be followed
+	void copyRows(const DataDef *from);
+	
+	//! Build a schema description of \a from
+	static QVector<Spec> describe(const DataDef *from);
+	
+private:
+	Q_DISABLE_COPY(ColumnMirror)
+	
+	ColumnPool *pool;
+	
+	DataDef mirror;
+	
+	//! Columns of #mirror by handle
+	QHash<ColumnHandle, Column*> clones;
+	
+	//! Version of the DataDef last passed to follow()
+	quint64 followed;
+};
 
 typedef QList<Module*> ModuleList;
 
+/*!
+ * \brief A condition on one Column which a line must meet to be kept
+ * 
+ * See Module::declareFilter() and Inlet::passesPushdown().
+ */
+struct LinePredicate {
+	
+	enum Kind {
+		Range,  //!< Kept if #min <= value <= #max
+		Equal,  //!< Kept if the value is #text, or #min for numeric Columns
+		Changed  //!< Kept if the value differs from that of the last line kept
+	};
+	
+	Kind kind;
+	ColumnHandle h;  //!< The Column tested
+	double min;
+	double max;
+	QByteArray text;
+	
+	bool operator==(const LinePredicate &o) const {
+		return kind == o.kind && h == o.h && min == o.min && max == o.max && text == o.text;
+	}
+	bool operator!=(const LinePredicate &o) const {return ! (*this == o);}
+};
+
+/*!
+ * \brief Tests lines against a list of LinePredicate
+ * 
+ * A line passes if it meets every Range and Equal predicate and, if there are
+ * any Changed predicates, at least one of them.  Predicates whose Column is
+ * not in the bound DataDef are ignored.  Text Columns are compared as text by
+ * Equal and Changed and parsed for Range, which text that does not parse
+ * never passes; Dictionary Columns are compared by their strings.
+ */
+class LineFilter {
+public:
+	
+	LineFilter() : bound(0), boundVersion(0) {}
+	
+	//! Replace the predicates, forgetting any Changed state
+	void setPredicates(const QVector<LinePredicate> &keep);
+	
+	const QVector<LinePredicate>& predicates() const {return keep;}
+	
+	bool isEmpty() const {return keep.isEmpty();}
+	
+	//! Whether any predicate is Changed, so lines must be tested in order
+	bool dependsOnOrder() const;
+	
+	//! Look up the tested Columns in \a columns unless it is unchanged
+	void bind(const DataDef *columns);
+	
+	//! Whether the current line passes; must be bound first
+	bool passes() {return test(-1);}
+	
+	//! Whether line \a row of the current batch passes; must be bound first
+	bool passes(int row) {return test(row);}
+	
+private:
+	
+	//! The bound state of one predicate
+	struct Test {
+		Column *c;  //!< The tested Column, or 0 if absent
+		bool seen;  //!< Changed only: whether #last holds a value
+		Column::Value last;  //!< Changed only: the last kept native value
+		QByteArray lastText;  //!< Changed only: the last kept text
+	};
+	
+	QVector<LinePredicate> keep;
+	QVector<Test> tests;
+	const DataDef *bound;
+	quint64 boundVersion;
+	
+	//! Test the current line (\a row < 0) or a batch line
+	bool test(int row);
+};
+
 #endif // DATA_H
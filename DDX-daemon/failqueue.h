@@ -0,0 +1,221 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef FAILQUEUE_H
+#define FAILQUEUE_H
+
+#include <QAtomicInteger>
+#include <functional>
+
+/*!
+ * \file failqueue.h
+ * Bounded single-producer/single-consumer queues for Inlets
+ * 
+ * \ingroup daemon
+ */
+
+/*!
+ * \brief Type-independent part of FailQueue
+ * 
+ * Holds the wakeup flag and statistics so that Inlets can manage queues of
+ * any transfer type.  See FailQueue.
+ */
+class FailQueueBase
+{
+public:
+	
+	explicit FailQueueBase(int capacity) {
+		// Round up to a power of two so that indices can be masked
+		cap = 1;
+		while (cap < capacity) cap <<= 1;
+		mask = cap - 1;
+	}
+	
+	virtual ~FailQueueBase() {}
+	
+	/*!
+	 * \brief Hand queued items to the processing function
+	 * \param max The maximum number of items to process
+	 * \return The number of items processed
+	 * 
+	 * Must only be called from the consumer thread.
+	 */
+	virtual int drain(int max) = 0;
+	
+	//! The number of items currently queued (approximate from the producer)
+	int size() const {return (int) (tail.loadAcquire() - head.loadAcquire());}
+	
+	//! The maximum number of items the queue can hold
+	int capacity() const {return (int) cap;}
+	
+	//! The deepest the queue has been when drained
+	int highWaterMark() const {return highWater.load();}
+	
+	//! The number of items dropped because the queue was full
+	quint64 overflowCount() const {return overflows.load();}
+	
+	/*!
+	 * \brief Set the function which schedules draining on the consumer thread
+	 * \param wake A thread-safe function which eventually causes drain() to be called
+	 * 
+	 * The function is called by the producer at most once between drains.
+	 */
+	void setWake(std::function<void()> wake) {this->wake = wake;}
+	
+	/*!
+	 * \brief Prepare for a drain
+	 * 
+	 * Must be called by the consumer immediately before draining.  Any item
+	 * pushed after this call will trigger another wake.
+	 */
+	void beginDrain() {
+		scheduled.storeRelease(0);
+		int depth = size();
+		if (depth > highWater.load()) highWater.store(depth);
+	}
+	
+	/*!
+	 * \brief Finish a drain
+	 * 
+	 * Must be called by the consumer after draining.  If the drain stopped
+	 * before the queue was empty, another wake is scheduled so that the event
+	 * loop gets a turn in between.
+	 */
+	void endDrain() {
+		if (size() > 0) requestWake();
+	}
+	
+protected:
+	quint64 cap;  //!< Capacity (a power of two)
+	quint64 mask;  //!< cap - 1
+	
+	// Producer and consumer indices live on separate cache lines
+	char pad0[64];
+	QAtomicInteger<quint64> tail;  //!< Next slot to write (written by producer)
+	quint64 headCache;  //!< Producer's last view of #head
+	QAtomicInteger<quint64> overflows;  //!< Written by producer only
+	char pad1[64];
+	QAtomicInteger<quint64> head;  //!< Next slot to read (written by consumer)
+	QAtomicInt highWater;  //!< Written by consumer only
+	char pad2[64];
+	QAtomicInt scheduled;  //!< Whether a wake is outstanding
+	
+	std::function<void()> wake;
+	
+	//! Schedule a drain unless one is already outstanding
+	void requestWake() {
+		if (scheduled.testAndSetOrdered(0, 1) && wake) wake();
+	}
+};
+
+/*!
+ * \brief A bounded, lock-free single-producer/single-consumer queue
+ * 
+ * A FailQueue moves items of type \a T from one producer thread (typically an
+ * Inlet's acquisition thread) to one consumer thread (the Path's thread)
+ * without locking.  The consumer hands each item to a processing member
+ * function of \a R, in order, in batches of up to a given size.
+ * 
+ * Following the DDX error handling philosophy, a full queue never blocks the
+ * producer.  The item is dropped and counted in overflowCount() instead, and
+ * the owning Inlet reports it.  Size the queue for the longest stall the Path
+ * is expected to have.
+ * 
+ * Each slot is reset to a default-constructed \a T once its item has been
+ * processed, so the queue never keeps the data of consumed items alive.
+ * 
+ * ## Usage
+ * Construct the queue in the Inlet, pass it to Inlet::attachQueue(), and call
+ * push() from the acquisition thread.  The processing function should write
+ * the item into the Inlet's Columns and call Inlet::process().
+ */
+template <typename T, typename R>
+class FailQueue : public FailQueueBase
+{
+public:
+	
+	//! The processing function called on the consumer thread for every item
+	typedef void (R::*Handler)(T &item);
+	
+	/*!
+	 * \brief FailQueue constructor
+	 * \param receiver The object whose \a handler is called
+	 * \param handler The processing function
+	 * \param capacity The minimum capacity (rounded up to a power of two)
+	 */
+	FailQueue(R *receiver, Handler handler, int capacity) : FailQueueBase(capacity) {
+		r = receiver;
+		h = handler;
+		buf = new T[cap];
+		headCache = 0;
+	}
+	
+	~FailQueue() {
+		delete[] buf;
+	}
+	
+	/*!
+	 * \brief Add an item to the queue
+	 * \param item The item
+	 * \return True on success, false if the queue was full and the item was dropped
+	 * 
+	 * Must only be called from the producer thread.
+	 */
+	bool push(const T &item) {
+		const quint64 t = tail.load();
+		if (t - headCache >= cap) {
+			headCache = head.loadAcquire();
+			if (t - headCache >= cap) {
+				overflows.store(overflows.load() + 1);
+				return false;
+			}
+		}
+		buf[t & mask] = item;
+		tail.storeRelease(t + 1);
+		requestWake();
+		return true;
+	}
+	
+	int drain(int max) override {
+		quint64 hd = head.load();
+		quint64 t = tail.loadAcquire();
+		int n = 0;
+		while (n < max) {
+			if (hd == t) {
+				t = tail.loadAcquire();
+				if (hd == t) break;
+			}
+			T &item = buf[hd & mask];
+			(r->*h)(item);
+			// Release what the item holds before the producer can reuse the slot
+			item = T();
+			head.storeRelease(++hd);
+			++n;
+		}
+		return n;
+	}
+	
+private:
+	Q_DISABLE_COPY(FailQueue)
+	
+	R *r;  //!< The receiver
+	Handler h;  //!< The processing function
+	T *buf;  //!< Ring storage
+};
+
+#endif // FAILQUEUE_H
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef FUSEDCHAIN_H
+#define FUSEDCHAIN_H
+
+#include <QList>
+#include <QByteArray>
+#include <tuple>
+#include <type_traits>
+#include "module.h"
+
+/*!
+ * \file fusedchain.h
+ * Compile-time fused chains of batch Modules
+ * 
+ * \ingroup daemon
+ */
+
+/*!
+ * \brief Runs a fixed sequence of Modules over a batch in a single loop
+ * 
+ * Paths use these in place of a run of Modules whose types match a chain
+ * registered with PathManager::registerFusedChain().  See FusedChainOf.
+ */
+class FusedChain
+{
+public:
+	virtual ~FusedChain() {}
+	
+	/*!
+	 * \brief Run every Module in the chain on a range of rows
+	 * \param first The first row
+	 * \param count The number of rows
+	 */
+	virtual void processBatch(int first, int count) = 0;
+};
+
+/*!
+ * \brief A FusedChain over Module types known at compile time
+ * 
+ * Each row is passed through every stage before moving on to the next, and
+ * the stages are called by their static types so that the compiler can
+ * inline the whole chain into one loop.  Stage types must:
+ * - Be `final` Module subclasses which reimplement Module::processesBatches()
+ * to return true
+ * - Define a public, non-virtual, inline `void processRow(int row)` which
+ * does for one row exactly what their Module::processBatch() does for each
+ * row, so that fused and unfused Paths give the same results
+ * - Not reconfigure, create, or remove Columns from processRow()
+ * - Not drop lines (see Module::dropsLines()), unless last in the chain
+ * 
+ * A stage whose processBatch() does some work once per batch, such as
+ * reading the clock, can define a public `void beginRows(int first, int
+ * count)` for it, which the chain calls before the first row of each batch.
+ * 
+ * A chain made up only of stateless Modules is never used, since running
+ * them in parallel on row ranges gains more than fusing them.
+ * 
+ * Fused Modules are still constructed, initialized, and reconfigured as
+ * usual; only the batch loop is replaced.
+ */
+template<class... Stages>
+class FusedChainOf final : public FusedChain
+{
+public:
+	
+	//! Number of Modules in the chain
+	static const int length = sizeof...(Stages);
+	
+	//! \brief Bind the chain to the first #length Modules of a list
+	explicit FusedChainOf(const QList<Module*> &modules) {
+		bind<0, Stages...>(modules);
+	}
+	
+	void processBatch(int first, int count) override {
+		beginRows<0, Stages...>(first, count);
+		for (int row = first, end = first + count; row < end; ++row)
+			runRow<0, Stages...>(row);
+	}
+	
+	//! The class names the chain matches, in order
+	static QList<QByteArray> types() {
+		QList<QByteArray> t;
+		addTypes<Stages...>(t);
+		return t;
+	}
+	
+	//! Factory for PathManager::registerFusedChain()
+	static FusedChain* create(const QList<Module*> &modules) {
+		return new FusedChainOf<Stages...>(modules);
+	}
+	
+private:
+	std::tuple<Stages*...> stages;
+	
+	template<int I>
+	void bind(const QList<Module*> &) {}
+	
+	template<int I, class S, class... Rest>
+	void bind(const QList<Module*> &modules) {
+		std::get<I>(stages) = static_cast<S*>(modules.at(I));
+		bind<I + 1, Rest...>(modules);
+	}
+	
+	template<int I>
+	void beginRows(int, int) {}
+	
+	template<int I, class S, class... Rest>
+	void beginRows(int first, int count) {
+		callBeginRows(std::get<I>(stages), first, count, 0);
+		beginRows<I + 1, Rest...>(first, count);
+	}
+	
+	//! Calls S::beginRows() if the stage defines it; preferred by the int argument
+	template<class S>
+	static auto callBeginRows(S *s, int first, int count, int) -> decltype(s->S::beginRows(first, count)) {
+		return s->S::beginRows(first, count);
+	}
+	
+	template<class S>
+	static void callBeginRows(S *, int, int, long) {}
+	
+	template<int I>
+	void runRow(int) {}
+	
+	template<int I, class S, class... Rest>
+	void runRow(int row) {
+		std::get<I>(stages)->S::processRow(row);
+		runRow<I + 1, Rest...>(row);
+	}
+	
+	template<class... None>
+	static typename std::enable_if<sizeof...(None) == 0>::type addTypes(QList<QByteArray> &) {}
+	
+	template<class S, class... Rest>
+	static void addTypes(QList<QByteArray> &t) {
+		t.append(S::staticMetaObject.className());
+		addTypes<Rest...>(t);
+	}
+};
+
+#endif // FUSEDCHAIN_H
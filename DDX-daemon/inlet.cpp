@@ -17,13 +17,20 @@
  ******************************************************************************/
 
 #include "inlet.h"
+#include "daemon.h"
 
 Inlet::Inlet(Path *parent, const QByteArray &name) : Module(parent, name) {
 	// TODO
+	reportedOverflows = 0;
+	pushdownGeneration = -1;
+	streamIsSynchronous = false;
+	streamIsFinite = false;
 }
 
 Inlet::~Inlet() {
 	// TODO
+	for (int i = 0; i < samplingChannels.size(); ++i)
+		path->d->getSampler()->removeChannel(samplingChannels.at(i));
 }
 
 void Inlet::init(rapidjson::Value &config) {
@@ -39,12 +46,110 @@ void Inlet::process() {
 	path->process();
 }
 
+void Inlet::setBatchSize(int lines) {
+	path->flushBatch();
+	path->batchSize = lines < 1 ? 1 : lines;
+}
+
 bool Inlet::isSynchronous() const {
-	// TODO
-	return false;
+	return streamIsSynchronous;
 }
 
 bool Inlet::isFinite() const {
-	// TODO
+	return streamIsFinite;
+}
+
+bool Inlet::readLine() {
+	alert("DDX bug: readLine() not reimplemented by a finite Inlet!");
 	return false;
 }
+
+int Inlet::readLines(qint64, int, int) {
+	alert("DDX bug: readLines() not reimplemented by a chunked Inlet!");
+	return 0;
+}
+
+void Inlet::drainFinite() {
+	// Stopped or finished since this was queued
+	if (path->state != Path::State::Running) return;
+	if (readsChunks()) {
+		if ( ! path->readChunks()) path->finish();
+		// Path::resumeSending() requeues this once the stages catch up
+		else if (path->held) path->inletStalled = true;
+		else QMetaObject::invokeMethod(this, "drainFinite", Qt::QueuedConnection);
+		return;
+	}
+	for (int i = 0; i < FINITE_DRAIN_LINES; ++i) {
+		if ( ! readLine()) {
+			path->finish();
+			return;
+		}
+		path->streamLines++;
+		if (path->held) {
+			path->inletStalled = true;
+			return;
+		}
+	}
+	QMetaObject::invokeMethod(this, "drainFinite", Qt::QueuedConnection);
+}
+
+void Inlet::attachQueue(FailQueueBase *q) {
+	queues.append(q);
+	q->setWake([this]() {
+		QMetaObject::invokeMethod(this, "drainQueues", Qt::QueuedConnection);
+	});
+}
+
+int Inlet::addSamplingChannel(qint64 period, const Sampler::Sample &sample) {
+	int id = path->d->getSampler()->addChannel(period, sample);
+	if (id < 0) alert(tr("Sampling channel with a period of %1 ns rejected").arg(period));
+	else samplingChannels.append(id);
+	return id;
+}
+
+void Inlet::removeSamplingChannel(int id) {
+	if ( ! samplingChannels.removeOne(id)) return;
+	path->d->getSampler()->removeChannel(id);
+}
+
+void Inlet::drainQueues() {
+	for (int i = 0; i < queues.size(); ++i) {
+		FailQueueBase *q = queues.at(i);
+		q->beginDrain();
+		q->drain(INLET_DRAIN_BATCH);
+		q->endDrain();
+	}
+	quint64 overflows = queueOverflowCount();
+	if (overflows != reportedOverflows) {
+		alert(tr("Inlet queue overflowed; %1 readings dropped").arg(overflows - reportedOverflows));
+		reportedOverflows = overflows;
+	}
+}
+
+bool Inlet::passesPushdown() {
+	if (pushdown.isEmpty()) return true;
+	pushdown.bind(&outputColumns);
+	return pushdown.passes();
+}
+
+void Inlet::refreshPushdown() {
+	int generation = path->liveGeneration.load();
+	if (generation == pushdownGeneration) return;
+	pushdownGeneration = generation;
+	QMutexLocker l(&path->liveLock);
+	if (path->pushdown != pushdown.predicates()) pushdown.setPredicates(path->pushdown);
+}
+
+int Inlet::queueHighWaterMark() const {
+	int hwm = 0;
+	for (int i = 0; i < queues.size(); ++i)
+		hwm = qMax(hwm, queues.at(i)->highWaterMark());
+	return hwm;
+}
+
+quint64 Inlet::queueOverflowCount() const {
+	quint64 ct = 0;
+	for (int i = 0; i < queues.size(); ++i)
+		ct += queues.at(i)->overflowCount();
+	return ct;
+}
@@ -23,14 +23,63 @@
 #include "daemon_constants.h"
 #include "path.h"
 #include "module.h"
+#include "sampler.h"
+#include "failqueue.h"
 
 /*!
  * \brief A Path's first Module, responsible for producing data lines
  * 
+ * ## Asynchronous Acquisition
+ * Inlets which read from a device on their own thread should not call
+ * process() from that thread.  Instead, they should push raw readings into a
+ * FailQueue registered with attachQueue().  The Path's thread drains the
+ * queue in batches of up to INLET_DRAIN_BATCH items, calling the queue's
+ * processing function for each one, which fills the Columns and calls
+ * process().  Dropped items are reported with alert() and counted in the
+ * Path's statistics.
+ * 
+ * ## Pushdown
+ * Inlets which parse their lines can avoid work for data nobody uses.  Fields
+ * whose Columns have Column#live cleared need not be parsed at all; see
+ * Module::insertColumn().  Downstream filters declared with
+ * Module::declareFilter() may also be passed up to the Inlet.  An Inlet which
+ * supports them parses the tested fields first and calls passesPushdown(),
+ * skipping the rest of the line and the call to process() if it fails.
+ * Inlets which never call it lose nothing; the lines are then dropped
+ * downstream instead.  Both take effect from the Inlet's next line.  Lines
+ * read with readLines() are filtered by the Path, so such Inlets need only
+ * skip dead fields.
+ * 
+ * ## Finite Streams
+ * Inlets reading a source with an end, such as a file replay or a backfill,
+ * should call setFinite() in init() and reimplement readLine() instead of
+ * pacing themselves with timers.  Once started, the Path calls readLine() in
+ * a tight loop, going back to the event loop only every #FINITE_DRAIN_LINES
+ * lines, so the stream runs as fast as the Path can take it.  At the end of
+ * the stream the Path finishes every line in flight, emits Path::finished(),
+ * and reports the lines per second achieved.
+ * 
+ * An Inlet which can find any line of its source on its own, such as one
+ * indexing the line breaks of a file, can also reimplement readsChunks() and
+ * readLines().  The Path then reads many chunks of lines at once on worker
+ * threads, runs each through the stateless Modules directly after the Inlet
+ * (see Module::isStateless()), and passes them on to the rest of the Path in
+ * their original order.  Other Modules run as usual.
+ * 
+ * ## Sampling
+ * Inlets which poll an instrument at a fixed rate should add a channel with
+ * addSamplingChannel() rather than run a QTimer.  Channels of every Inlet
+ * share the Daemon's Sampler, which wakes on drift-free absolute deadlines
+ * and samples every channel due at once, recording how late each sample
+ * ran.  Sampling functions run on the Sampler's thread, so they should only
+ * take the reading and push it into a queue attached with attachQueue().
+ * The jitter of each channel is reported in Path::publishStats().
+ * 
  * \ingroup daemon
  */
 class Inlet : public Module
 {
+	friend class Path;
 	Q_OBJECT
 public:
 	
@@ -55,7 +104,10 @@ public:
 	/*!
 	 * \brief Trigger processing
 	 * 
-	 * Calls Path::process(); see docs for requirements
+	 * Calls Path::process(); see docs for requirements.  If a batch size
+	 * greater than one has been set, the line is queued and the batch is run
+	 * when it is full or when control returns to the event loop, whichever
+	 * comes first.
 	 */
 	void process() final;
 	
@@ -71,6 +123,36 @@ public:
 	 */
 	bool isFinite() const;
 	
+	/*!
+	 * \brief Produce the next line of a finite stream
+	 * \return False at the end of the stream
+	 * 
+	 * Only called for Inlets which called setFinite().  Fill the Columns and
+	 * call process() as usual, or skip the call to drop the line.  See the
+	 * Finite Streams section above.
+	 */
+	virtual bool readLine();
+	
+	/*!
+	 * \brief Whether the Path should call readLines() instead of readLine()
+	 * \return False unless reimplemented
+	 */
+	virtual bool readsChunks() const {return false;}
+	
+	/*!
+	 * \brief Read a range of lines of a finite stream into batch rows
+	 * \param line Index in the stream of the first line to read
+	 * \param row The batch row to store it in
+	 * \param count The number of lines to read
+	 * \return The number read, fewer than \a count only at the end of the stream
+	 * 
+	 * Called from several threads at once with disjoint ranges, and must
+	 * follow the rules of a stateless Module::processBatch(): only write
+	 * Column#rows and Column#rowText within the range, and never call
+	 * process() or change any Columns.  Dead Columns may be left unparsed.
+	 */
+	virtual int readLines(qint64 line, int row, int count);
+	
 	/*!
 	 * \brief Flag Inlet for starting
 	 * 
@@ -87,7 +169,102 @@ public:
 	
 	~Inlet();
 	
+	//! The deepest any attached queue has been when drained
+	int queueHighWaterMark() const;
+	
+	//! The number of items dropped by all attached queues
+	quint64 queueOverflowCount() const;
+	
+protected:
+	
+	/*!
+	 * \brief Set the maximum number of lines handed to the Path at once
+	 * \param lines The batch size; 1 (the default) disables batching
+	 * 
+	 * Batching trades a small amount of latency within a single event loop
+	 * iteration for far fewer per-line calls through the Path.  It is most
+	 * useful for Inlets which produce many lines per event, such as file
+	 * readers and buffered serial readers.  Inserting or removing columns
+	 * automatically flushes any lines already queued.
+	 */
+	void setBatchSize(int lines);
+	
+	/*!
+	 * \brief Declare whether this Inlet's stream has an end
+	 * \param finite Whether it does; false by default
+	 * 
+	 * Must be called from init().  See the Finite Streams section above.
+	 */
+	void setFinite(bool finite) {streamIsFinite = finite;}
+	
+	/*!
+	 * \brief Have the Path's thread drain a queue
+	 * \param q The queue, which must outlive this Inlet's use of it
+	 * 
+	 * Must be called from init() or the Path's thread, before the producer
+	 * begins pushing items.
+	 */
+	void attachQueue(FailQueueBase *q);
+	
+	/*!
+	 * \brief Sample something at a fixed rate
+	 * \param period The period in nanoseconds
+	 * \param sample The sampling function; see Sampler::Sample
+	 * \return An ID for removeSamplingChannel(), or -1 on failure
+	 * 
+	 * See the Sampling section above.  Channels still added when the Inlet is
+	 * destroyed are removed automatically.
+	 */
+	int addSamplingChannel(qint64 period, const Sampler::Sample &sample);
+	
+	//! Stop sampling a channel; afterwards its function is not running or called again
+	void removeSamplingChannel(int id);
+	
+	/*!
+	 * \brief Whether the current values pass the filters pushed down from downstream
+	 * \return False if the line would be dropped before reaching any Module
+	 * 
+	 * See the Pushdown section above.  Always true when nothing was pushed
+	 * down.  Must be called from the Path's thread.
+	 */
+	bool passesPushdown();
+	
+	//! The predicates currently pushed down to this Inlet
+	const QVector<LinePredicate>& pushedPredicates() const {return pushdown.predicates();}
+	
+private slots:
+	
+	//! Drains all attached queues; scheduled by the queues themselves
+	void drainQueues();
+	
+	/*!
+	 * \brief Read up to #FINITE_DRAIN_LINES lines of a finite stream, then requeue
+	 * 
+	 * Stops early, without requeueing, while the Path holds a batch its
+	 * stages cannot take yet; Path::resumeSending() then requeues it.
+	 */
+	void drainFinite();
+	
 private:
+	
+	//! Queues attached with attachQueue() (not owned)
+	QList<FailQueueBase*> queues;
+	
+	//! Overflows already reported with alert()
+	quint64 reportedOverflows;
+	
+	//! IDs of channels added with addSamplingChannel()
+	QList<int> samplingChannels;
+	
+	//! Predicates passed up by the Path; see passesPushdown()
+	LineFilter pushdown;
+	
+	//! Path::liveGeneration as of the last refreshPushdown(), or -1
+	int pushdownGeneration;
+	
+	//! Take up the Path's current pushdown if it changed
+	void refreshPushdown();
+	
 	bool streamIsSynchronous;
 	bool streamIsFinite;
 };
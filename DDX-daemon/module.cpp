@@ -27,6 +27,13 @@ Module::Module(Path *parent, const QByteArray &name) : QObject(parent)
 	/* This is safe to instantiate in the constructor because it is only a data
 	 * class.  Moving a Module to a separate thread should not harm anything. */
 	newColumns = 0;
+	inputColumns = 0;
+	configured = false;
+	declared = false;
+	replayable = true;
+	inputVersion = 0;
+	liveGeneration = -1;
+	lineDropped = false;
 }
 
 Module::~Module()
@@ -58,10 +65,89 @@ rapidjson::Value Module::publishActions(rapidjson::MemoryPoolAllocator<> &a) con
 	return Value(kArrayType);  // Return no actions
 }
 
-void Module::reconfigure() {
+void Module::processBatch(int first, int count) {
+	alert("DDX bug: processBatch() not reimplemented!");
+	(void) first;
+	(void) count;
+}
+
+bool Module::reconfigure() {
+	if (configured && inputVersion == inputColumns->version()) return false;
+	inputVersion = inputColumns->version();
+	if (configured && declared && replayable && ! inputChangeAffects()) {
+		replayEdits();
+		return false;
+	}
 	if (newColumns) emptyNewColumns();
+	edits.resize(0);
+	deps.resize(0);
+	replayable = true;
 	outputColumns = *inputColumns;
+	configured = true;
+	liveGeneration = -1;  // The inserted Columns are new
 	handleReconfigure();
+	// Snapshot what this configuration depends on
+	for (int i = 0; i < reads.size(); ++i)
+		addDependency(reads.at(i));
+	for (int i = 0; i < writes.size(); ++i)
+		addDependency(writes.at(i));
+	return true;
+}
+
+void Module::declareColumns(const QVector<ColumnHandle> &reads, const QVector<ColumnHandle> &writes) {
+	this->reads = reads;
+	this->writes = writes;
+	declared = true;
+}
+
+void Module::declareFilter(const QVector<LinePredicate> &keep) {
+	if (keep == filter.predicates()) return;
+	filter.setPredicates(keep);
+	if (path) path->invalidatePlan(this);
+}
+
+void Module::addDependency(ColumnHandle h) {
+	Column *c = inputColumns->find(h);
+	Dependency d = {h, c, c ? c->t : Column::Text};
+	deps.append(d);
+}
+
+bool Module::inputChangeAffects() const {
+	for (int i = 0; i < deps.size(); ++i) {
+		const Dependency &d = deps.at(i);
+		Column *c = inputColumns->find(d.h);
+		/* Compare types as well because the Path's ColumnPool may hand a
+		 * recycled Column back to an upstream Module under the same name */
+		if (c != d.c || (c && c->t != d.t)) return true;
+	}
+	return false;
+}
+
+void Module::replayEdits() {
+	outputColumns = *inputColumns;
+	for (int i = 0; i < edits.size(); ++i) {
+		const ColumnEdit &e = edits.at(i);
+		switch (e.op) {
+		case ColumnEdit::Insert: {
+			// Resolved against the new input, which may have gained Columns
+			int after = e.other ? outputColumns.indexOf(e.other) : -1;
+			int at = e.a;
+			if ( ! e.b) at = outputColumns.size();
+			else if ( ! e.other) at = 0;
+			else if (after >= 0) at = after + 1;
+			outputColumns.insert(at, (Column*) e.c);
+			break;
+		}
+		case ColumnEdit::Remove:
+			outputColumns.removeOne(e.c);
+			break;
+		case ColumnEdit::Swap: {
+			int i = outputColumns.indexOf(e.c), j = outputColumns.indexOf(e.other);
+			if (i >= 0 && j >= 0) outputColumns.swap(i, j);
+			break;
+		}
+		}
+	}
 }
 
 void Module::alert(const QString msg) const {
@@ -72,27 +158,59 @@ void Module::log(const QString msg) const {
 	path->log(msg, this);
 }
 
+QDateTime Module::getTime() const {
+	return path->getTime();
+}
+
 Column* Module::findColumn(const QString name) const {
-	for (int i = 0; i < outputColumns.size(); ++i)
-		if (QString::compare(outputColumns.at(i)->n, name, Qt::CaseInsensitive) == 0)
-			return outputColumns.at(i);
-	return 0;
+	ColumnHandle h = ColumnNames::find(name);
+	if (h < 0) return 0;
+	return findColumn(h);
 }
 
-Column *Module::insertColumn(const QString name, int index) {
-	if (findColumn(name)) return 0;
-	if ( ! newColumns) newColumns = new DataDef();
-	Column *c = new Column(name, this);
-	newColumns->append(c);
-	outputColumns.insert(index, c);
-	return c;
+Column *Module::insertColumn(const QString name, int index, Column::Type type) {
+	return createColumn(ColumnNames::intern(name), name, index, type);
+}
+
+Column *Module::insertColumn(ColumnHandle h, int index, Column::Type type) {
+	return createColumn(h, ColumnNames::name(h), index, type);
 }
 
 void Module::removeColumn(const Column *c) {
-	outputColumns.removeOne((Column*) c);
+	if ( ! c) return;
+	// Only the Inlet can change structure with lines waiting in a batch
+	if (path && ! inputColumns) path->flushBatch();
+	outputColumns.removeOne(c);
 	if (c->p == this) {
 		newColumns->removeOne((Column*) c);
-		delete c;
+		/* Dropping the insert is equivalent to recording the removal, unless
+		 * later swaps were recorded relative to it */
+		for (int i = edits.size() - 1; i >= 0; --i) {
+			if (edits.at(i).op == ColumnEdit::Swap) replayable = false;
+			if (edits.at(i).op == ColumnEdit::Insert && edits.at(i).c == c) {
+				edits.remove(i);
+				break;
+			}
+		}
+		releaseColumn((Column*) c);
+	}
+	else if (inputColumns) {
+		ColumnEdit e = {ColumnEdit::Remove, 0, 0, c, 0};
+		edits.append(e);
+		// The removed Column must still be there for the edit to be replayed
+		addDependency(c->h);
+	}
+}
+
+void Module::swapColumns(int i, int j) {
+	if (i < 0 || j < 0 || i >= outputColumns.size() || j >= outputColumns.size()) return;
+	outputColumns.swap(i, j);
+	if (inputColumns) {
+		ColumnEdit e = {ColumnEdit::Swap, 0, 0, outputColumns.at(j), outputColumns.at(i)};
+		edits.append(e);
+		// Both Columns must still be there for the edit to be replayed
+		addDependency(e.c->h);
+		addDependency(e.other->h);
 	}
 }
 
@@ -101,7 +219,56 @@ void Module::terminate(const QString msg) {
 	path->terminate();
 }
 
+Column *Module::createColumn(ColumnHandle h, const QString &name, int index, Column::Type type) {
+	if (outputColumns.find(h)) return 0;
+	// Lines still waiting in a batch were produced with the Inlet's old structure
+	if (path && ! inputColumns) path->flushBatch();
+	if ( ! newColumns) newColumns = new QList<Column*>();
+	Column *c = path ? path->columnPool.acquire(h, name, this, type) : new Column(name, this, type);
+	newColumns->append(c);
+	int size = outputColumns.size();
+	if (index < 0) index = 0;
+	if (index > size) index = size;
+	const Column *after = index ? outputColumns.at(index - 1) : 0;
+	outputColumns.insert(index, c);
+	// Inlets have no input to replay onto
+	if (inputColumns) {
+		ColumnEdit e = {ColumnEdit::Insert, index, size - index, c, after};
+		edits.append(e);
+		// The inserted name must still be free for the edit to be replayed
+		addDependency(h);
+	}
+	return c;
+}
+
+inline void Module::releaseColumn(Column *c) {
+	if (path) path->columnPool.release(c);
+	else delete c;
+}
+
 inline void Module::emptyNewColumns() {
-	qDeleteAll(*newColumns);
-	newColumns->clear();
+	for (int i = 0; i < newColumns->size(); ++i)
+		releaseColumn(newColumns->at(i));
+	// Erasing rather than clearing keeps the list's capacity
+	newColumns->erase(newColumns->begin(), newColumns->end());
+}
+
+void Module::prepareBatch(int lines) {
+	refreshLiveness();
+	if (dropsLines()) droppedRows.fill(0, lines);
+	if ( ! newColumns) return;
+	for (int i = 0; i < newColumns->size(); ++i)
+		newColumns->at(i)->resizeRows(lines);
+}
+
+void Module::refreshLiveness() {
+	int generation = path->liveGeneration.load();
+	if (generation == liveGeneration) return;
+	liveGeneration = generation;
+	if ( ! newColumns) return;
+	QMutexLocker l(&path->liveLock);
+	for (int i = 0; i < newColumns->size(); ++i) {
+		Column *c = newColumns->at(i);
+		c->live = ! path->deadHandles.contains(c->h);
+	}
 }
@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QDateTime>
 #include "../rapidjson/include/rapidjson/document.h"
 #include "../rapidjson/include/rapidjson/stringbuffer.h"
 #include "../rapidjson/include/rapidjson/writer.h"
@@ -44,6 +45,31 @@ class Path;
  * calls to handleReconfigure.
  * - cleanup() is called immediately before destruction.
  * 
+ * ### Batch Processing
+ * Inlets may hand lines to their Path in batches; see Inlet::setBatchSize().
+ * A Module which reimplements processesBatches() to return true will then
+ * have processBatch() called once per batch instead of process() once per
+ * line, letting it run a tight loop over Column#rows.  Modules which do not
+ * are driven line-by-line as usual, so existing Modules need no changes.
+ * 
+ * ### Stateless Modules
+ * A batch Module which is a pure per-line transform, such as a calibration or
+ * unit conversion, can also reimplement isStateless() to return true.  Its
+ * Path may then split a batch into row ranges and run consecutive stateless
+ * Modules on those ranges in parallel, with every range finished before the
+ * next stateful Module runs.
+ * 
+ * ### Dropping Lines
+ * A Module which reimplements dropsLines() to return true can stop lines
+ * from going any further, with dropLine() from process() or dropRow() from
+ * processBatch().  Dropped lines are removed from the batch once the Module
+ * (or the parallel or fused run it is part of) finishes, so that nothing
+ * downstream spends any time on them.  Like filters, drops are ignored in
+ * Paths with branches, and the Path alerts about each such Module when it
+ * starts up.  A Module which holds results back until a later line, such as
+ * one closing a time bucket, can send them at the end of a finite stream
+ * from finishStream().
+ * 
  * ## Modifying %Column Structure
  * While input columns are determined externally, a Module can redefine its
  * output columns without inflicting any changes upstream.  The following
@@ -51,19 +77,45 @@ class Path;
  * - Removing columns: removeColumn() removes a column from the output; the
  * incoming value is still available.
  * - Inserting columns: insertColumn() adds a new column to the output which
- * must be set in process().
- * - Rearranging columns: Because ::DataDef is simply a typedef of
- * QList<Column*>, QList::swap() can be used to safely reorder columns.
+ * must be set in process().  Columns can be inserted with a native
+ * Column::Type so that numbers and timestamps are never formatted to text
+ * unless a downstream Module asks for it with Column::text().
+ * - Rearranging columns: swapColumns() can be used to safely reorder
+ * columns.
  * - Renaming columns: Columns can be renamed by removing the original,
  * inserting a new one, and including copy code in process().
  * 
+ * ### Selective Reconfiguration
+ * By default, handleReconfigure() is called whenever anything upstream
+ * changes.  A Module which calls declareColumns() promises that it depends only
+ * on the Columns it declares plus the ones it inserts, removes and swaps.
+ * When an upstream change leaves all of those untouched, the Path skips its
+ * handleReconfigure() and instead replays its previous insertColumn(),
+ * removeColumn(), and swapColumns() calls onto the new input, keeping the
+ * same inserted Column instances.  Inserted Columns go back after the Column
+ * they followed, or at the end if they were appended, and swaps exchange
+ * the same two Columns, so Columns added upstream do not shift them.
+ * Modules which opt in must make every structural change through those
+ * functions.
+ * 
+ * ### Dead Columns
+ * The Path keeps track of which Columns each Module reads: those it declared
+ * with declareColumns(), or every input Column for Modules which have not
+ * declared.  Inserted Columns which no Module downstream reads have
+ * Column#live cleared, so that producers can skip computing them and Inlets
+ * can skip parsing those fields at all.  Modules see changes to Column#live
+ * from their next line or batch on.  A Module which reads a Column it did not
+ * declare will find stale values in it when nothing else reads it.
+ * 
  * ### %Column Naming Conventions
  * Because Column names are meant to be globally unique but human-readable
  * identifiers within paths, searches are case-insensensitive and duplicates
- * which vary in case are disallowed.  Be wary, however, of the fact that a
- * column can be removed by one Module and replaced with another of the same
- * name by a Module downstream without complaint.  Relying on this hack is
- * not recommended.
+ * which vary in case are disallowed.  Names are interned into ColumnNames, so
+ * Modules which look up the same columns on every reconfigure can save the
+ * ::ColumnHandle once and pass it to findColumn() instead of the name.  Be
+ * wary, however, of the fact that a column can be removed by one Module and
+ * replaced with another of the same name by a Module downstream without
+ * complaint.  Relying on this hack is not recommended.
  * 
  * ## %Module %Settings
  * Modules can publish a tree of settings which must be configured by someone
@@ -107,6 +159,7 @@ class Path;
  */
 class Module : public QObject
 {
+	friend class Path;
 	Q_OBJECT
 public:
 	
@@ -165,6 +218,60 @@ public:
 	 */
 	virtual void process() = 0;
 	
+	/*!
+	 * \brief Handle a batch of data lines
+	 * \param first The first line of the batch to handle
+	 * \param count The number of lines to handle
+	 * 
+	 * Only called if processesBatches() returns true.  Line values are found
+	 * in Column#rows (for native types) or Column#rowText (for text types) of
+	 * any Column saved in handleReconfigure(), and results must be written back
+	 * to the same row of output Columns.  Row storage for inserted Columns is
+	 * allocated before this is called.  The same error handling rules apply as
+	 * for process().
+	 */
+	virtual void processBatch(int first, int count);
+	
+	/*!
+	 * \brief Whether this Module reimplements processBatch()
+	 * \return False unless reimplemented
+	 * 
+	 * Consecutive Modules which return false are run line-by-line through
+	 * process() within a batch, sharing a single load and store of each line.
+	 */
+	virtual bool processesBatches() const {return false;}
+	
+	/*!
+	 * \brief Whether processBatch() can run on several row ranges at once
+	 * \return False unless reimplemented
+	 * 
+	 * Ignored unless processesBatches() also returns true.  When true,
+	 * processBatch() may be called concurrently from several threads with
+	 * disjoint ranges.  It must then read and write only Column#rows and
+	 * Column#rowText within its range: no Module members, no current values
+	 * such as Column::setDouble() or Column::text(), no Column::setString(),
+	 * and no calls to Path::reconfigure().  alert() and log() are safe.
+	 */
+	virtual bool isStateless() const {return false;}
+	
+	/*!
+	 * \brief Whether this Module may call dropLine() or dropRow()
+	 * \return False unless reimplemented
+	 */
+	virtual bool dropsLines() const {return false;}
+	
+	/*!
+	 * \brief Send on results held back for lines already dropped
+	 * \return Whether the current values of the output Columns hold another line
+	 * 
+	 * Called at the end of a finite stream, once every line has gone through
+	 * the whole Path, until it returns false.  Each line it produces goes
+	 * through the rest of the Path with process().  Columns it does not set
+	 * keep whatever current values they last had.  False unless
+	 * reimplemented.
+	 */
+	virtual bool finishStream() {return false;}
+	
 	/*!
 	 * \brief Return a JSON tree of settings for this Module
 	 * \param a The RapidJSON allocator to use
@@ -180,8 +287,13 @@ public:
 	 * \brief Manages reconfiguration
 	 * 
 	 * Resets columns to their starting state and calls handleReconfigure().
+	 * Nothing is done if the input schema version has not changed since the
+	 * last call, and Modules which have called declareColumns() only have
+	 * their structural edits replayed if none of their Columns changed.
+	 * 
+	 * \return Whether handleReconfigure() was called
 	 */
-	void reconfigure();
+	bool reconfigure();
 	
 	/*!
 	 * \brief Called before destruction
@@ -224,15 +336,21 @@ protected:
 	 * reimplemented._
 	 * 
 	 * ### Initial State
-	 * Prior to every call, previously inserted Columns are destroyed and the
-	 * input column structure is copied to the output column structure.
+	 * Prior to every call, previously inserted Columns are returned to the
+	 * Path's ColumnPool, from which insertColumn() may hand them back, and the
+	 * output column structure is set to the input column structure.  This is
+	 * a shared reference, not a copy, so a Module which makes no structural
+	 * changes costs nothing to reconfigure; see DataDef.
 	 * 
 	 * ### Fast Buffer Access
-	 * Because findColumn() does a slow linear search through the column list,
-	 * it is best to only do this search once and then save a pointer directly
-	 * to a column's buffer for reading and/or writing during process().  Once
-	 * a column has been found, subclasses should store the result of
-	 * Column::buffer() to refer to the result in the future.
+	 * Although findColumn() is a hash lookup, it is still best to only do this
+	 * search once and then save a pointer directly to a column's buffer for
+	 * reading and/or writing during process().  Once
+	 * a column has been found, subclasses should store the Column pointer (or,
+	 * for text columns, the result of Column::buffer()) to refer to the result
+	 * in the future.  Check Column#t to determine how a found Column's value
+	 * should be read; Column::toDouble() and Column::toInt() work for any
+	 * type but only parse text when they have to.
 	 * 
 	 * ### Error Handling
 	 * See the Module class documentation for general information on error
@@ -260,6 +378,15 @@ protected:
 	 */
 	void log(const QString msg) const;
 	
+	/*!
+	 * \brief Obtain the current date and time on the Path's clock
+	 * \return The time in DDX standard form
+	 * 
+	 * Use this rather than Daemon::getTime() so that replays at other than
+	 * real time see the time of the data; see PathClock.
+	 */
+	QDateTime getTime() const;
+	
 	/*!
 	 * \brief Get a pointer to a specific input Column
 	 * \param name The Column's case-insensitive name
@@ -273,20 +400,47 @@ protected:
 	 */
 	Column* findColumn(const QString name) const;
 	
+	/*!
+	 * \brief Get a pointer to a specific input Column by handle
+	 * \param h The Column's handle from ColumnNames
+	 * \return A pointer to the Column or 0 if it doesn't exist
+	 * 
+	 * Identical to findColumn(const QString) but skips interning the name.
+	 */
+	Column* findColumn(ColumnHandle h) const {return outputColumns.find(h);}
+	
 	/*!
 	 * \brief Generate a new Column and add it to the output Columns
 	 * \param name A unique, case-insensitive identifier
 	 * \param index Position index in the Module's output columns
+	 * \param type The native value type of the column
 	 * \return A pointer to the created column (must be saved!) or 0
 	 * 
 	 * Generates a new column buffer, adds it to the Module's output columns,
 	 * and adds a reference to the accessor map.  This function will first
 	 * search for an existing output Column with the given name.  If one is
-	 * found, it returns 0.
+	 * found, it returns 0.  Columns are recycled through the Path's
+	 * ColumnPool, so a Module which inserts the same Columns on every
+	 * reconfigure does not allocate after the first.  Setting the Column's
+	 * value can be skipped whenever Column#live is false.
+	 * 
+	 * __Unsafe outside of reconfigure() or handleReconfigure()!__
+	 */
+	Column *insertColumn(const QString name, int index, Column::Type type = Column::Text);
+	
+	/*!
+	 * \brief Generate a new Column by handle and add it to the output Columns
+	 * \param h The handle of the Column's name from ColumnNames
+	 * \param index Position index in the Module's output columns
+	 * \param type The native value type of the column
+	 * \return A pointer to the created column (must be saved!) or 0
+	 * 
+	 * Identical to insertColumn(const QString, int, Column::Type) but skips
+	 * interning the name.
 	 * 
 	 * __Unsafe outside of reconfigure() or handleReconfigure()!__
 	 */
-	Column *insertColumn(const QString name, int index);
+	Column *insertColumn(ColumnHandle h, int index, Column::Type type = Column::Text);
 	
 	/*!
 	 * \brief Remove an output Column
@@ -299,6 +453,58 @@ protected:
 	 */
 	void removeColumn(const Column *c);  // Unsafe outside of handleReconfigure();
 	
+	/*!
+	 * \brief Exchange the positions of two output Columns
+	 * \param i The position of the first Column
+	 * \param j The position of the second Column
+	 * 
+	 * __Unsafe outside of reconfigure() or handleReconfigure()!__
+	 */
+	void swapColumns(int i, int j);
+	
+	/*!
+	 * \brief Declare which existing Columns this Module reads and writes
+	 * \param reads Handles of Columns read in process()
+	 * \param writes Handles of upstream Columns modified in process()
+	 * 
+	 * Opts in to selective reconfiguration; see the Module class
+	 * documentation.  Columns this Module inserts need not be declared.  Can
+	 * be called in init() or handleReconfigure(); each call replaces the
+	 * previous declaration.
+	 */
+	void declareColumns(const QVector<ColumnHandle> &reads, const QVector<ColumnHandle> &writes);
+	
+	/*!
+	 * \brief Declare which lines this Module should be given
+	 * \param keep Predicates which a line must meet; see LineFilter
+	 * 
+	 * Lines which fail are dropped by the Path before they reach this Module,
+	 * so neither it nor anything downstream sees them.  When every Module
+	 * between the Inlet and this one is a stateless Module which has called
+	 * declareColumns() and does not write the tested Columns, the predicates
+	 * are also passed up to the Inlet so that it can drop lines at the source;
+	 * see Inlet::passesPushdown().  Ignored in Paths with branches.  Can be
+	 * called in init() or handleReconfigure(); each call replaces the
+	 * previous declaration.
+	 */
+	void declareFilter(const QVector<LinePredicate> &keep);
+	
+	/*!
+	 * \brief Keep the current line from going any further
+	 * 
+	 * Only call from process(), and only if dropsLines() returns true.  See
+	 * the Dropping Lines section above.
+	 */
+	void dropLine() {lineDropped = true;}
+	
+	/*!
+	 * \brief Keep line \a row of the current batch from going any further
+	 * 
+	 * Only call from processBatch(), and only if dropsLines() returns true.
+	 * Safe from stateless Modules running in parallel.
+	 */
+	void dropRow(int row) {droppedRows[row] = 1;}
+	
 	void terminate(const QString msg);
 	
 private:
@@ -309,16 +515,86 @@ private:
 	//! Pointer to external input columns (this is not owned!)
 	const DataDef *inputColumns;  // NOT OWNED
 	
+	//! The input schema version as of the last reconfigure()
+	quint64 inputVersion;
+	
+	//! Whether reconfigure() has ever called handleReconfigure()
+	bool configured;
+	
+	//! Whether declareColumns() has been called
+	bool declared;
+	
+	//! Whether #edits can be replayed faithfully
+	bool replayable;
+	
+	//! Handles declared with declareColumns()
+	QVector<ColumnHandle> reads, writes;
+	
+	//! Lines to drop before this Module; see declareFilter()
+	LineFilter filter;
+	
+	//! Whether process() called dropLine() for the current line
+	bool lineDropped;
+	
+	//! Rows of the current batch dropRow() was called for, if dropsLines()
+	QVector<char> droppedRows;
+	
+	//! A structural change made during handleReconfigure(), kept for replay
+	struct ColumnEdit {
+		enum Op {Insert, Remove, Swap} op;
+		int a;  //!< Insert only: position, used if #other is gone
+		int b;  //!< Insert only: Columns after the position, 0 if appended
+		const Column *c;  //!< Inserted, removed or first swapped Column
+		const Column *other;  //!< Column the insert followed (0 if first), or second swapped Column
+	};
+	
+	//! Structural changes made during the last handleReconfigure()
+	QVector<ColumnEdit> edits;
+	
+	//! An input Column as it was when handleReconfigure() last ran
+	struct Dependency {
+		ColumnHandle h;
+		const Column *c;  //!< The Column found, or 0 if the name was absent
+		Column::Type t;
+	};
+	
+	//! Everything in the input the last configuration depends on
+	QVector<Dependency> deps;
+	
+	//! Record the current input state of \a h as a dependency
+	void addDependency(ColumnHandle h);
+	
+	//! Whether the current input differs from #deps
+	bool inputChangeAffects() const;
+	
+	//! Apply #edits to the current input instead of calling handleReconfigure()
+	void replayEdits();
+	
 	/*!
 	 * \brief List of Columns created by this Module for garbage collection
 	 * 
 	 * Note that this will be a null pointer unless a Column was previously
 	 * inserted by a Module.
 	 */
-	DataDef *newColumns;  // Super and elements owned
+	QList<Column*> *newColumns;  // Super and elements owned
+	
+	//! Creates a Column from the Path's ColumnPool; see insertColumn()
+	Column *createColumn(ColumnHandle h, const QString &name, int index, Column::Type type);
+	
+	//! Returns a Column to the Path's ColumnPool
+	inline void releaseColumn(Column *c);
 	
 	//! Garbage collects inserted Columns
 	inline void emptyNewColumns();
+	
+	//! Allocates batch row storage for inserted Columns
+	void prepareBatch(int lines);
+	
+	//! Path::liveGeneration as of the last refreshLiveness(), or -1
+	int liveGeneration;
+	
+	//! Update Column#live of inserted Columns if the Path's liveness changed
+	void refreshLiveness();
 };
 
 #endif // MODULE_H
@@ -0,0 +1,181 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "deadbandmodule.h"
+#include "../rapidjson_using.h"
+#include <cmath>
+#include <limits>
+
+DeadbandModule::~DeadbandModule() {
+	
+}
+
+void DeadbandModule::init(rapidjson::Value &config) {
+	double absolute = 0, relative = 0;
+	heartbeatMsecs = 0;
+	timeHandle = -1;
+	timeColumn = 0;
+	started = false;
+	lastPassed = 0;
+	if (config.IsObject()) {
+		Value::MemberIterator it = config.FindMember("Absolute");
+		if (it != config.MemberEnd() && it->value.IsNumber()) absolute = std::fabs(it->value.GetDouble());
+		it = config.FindMember("Relative");
+		if (it != config.MemberEnd() && it->value.IsNumber()) relative = std::fabs(it->value.GetDouble());
+		it = config.FindMember("Heartbeat");
+		if (it != config.MemberEnd() && it->value.IsNumber() && it->value.GetDouble() > 0)
+			heartbeatMsecs = qMax((qint64) (it->value.GetDouble() * 1000), (qint64) 1);
+		it = config.FindMember("Time");
+		if (it != config.MemberEnd() && it->value.IsString())
+			timeHandle = ColumnNames::intern(QString::fromUtf8(it->value.GetString(), it->value.GetStringLength()));
+		it = config.FindMember("Columns");
+		if (it != config.MemberEnd() && it->value.IsArray())
+			for (Value::ValueIterator c = it->value.Begin(); c != it->value.End(); ++c) {
+				Channel ch;
+				ch.absolute = absolute;
+				ch.relative = relative;
+				ch.column = 0;
+				ch.exact = false;
+				ch.last = 0;
+				if (c->IsString())
+					ch.handle = ColumnNames::intern(QString::fromUtf8(c->GetString(), c->GetStringLength()));
+				else if (c->IsObject() && c->HasMember("Name") && (*c)["Name"].IsString()) {
+					Value &name = (*c)["Name"];
+					ch.handle = ColumnNames::intern(QString::fromUtf8(name.GetString(), name.GetStringLength()));
+					if (c->HasMember("Absolute") && (*c)["Absolute"].IsNumber())
+						ch.absolute = std::fabs((*c)["Absolute"].GetDouble());
+					if (c->HasMember("Relative") && (*c)["Relative"].IsNumber())
+						ch.relative = std::fabs((*c)["Relative"].GetDouble());
+				}
+				else {
+					alert(tr("Ignoring a column without a name"));
+					continue;
+				}
+				channels.append(ch);
+			}
+	}
+	if (channels.isEmpty()) alert(tr("No columns to monitor were configured"));
+	QVector<ColumnHandle> reads;
+	for (int k = 0; k < channels.size(); ++k)
+		reads.append(channels.at(k).handle);
+	if (timeHandle >= 0) reads.append(timeHandle);
+	declareColumns(reads, QVector<ColumnHandle>());
+}
+
+void DeadbandModule::handleReconfigure() {
+	for (int k = 0; k < channels.size(); ++k) {
+		Channel &ch = channels[k];
+		ch.column = findColumn(ch.handle);
+		if ( ! ch.column) {
+			alert(tr("Column '%1' not found").arg(ColumnNames::name(ch.handle)));
+			continue;
+		}
+		ch.exact = ! ch.absolute && ! ch.relative && (ch.column->t == Column::Text || ch.column->t == Column::Bytes
+		                                              || ch.column->t == Column::Bool || ch.column->t == Column::Dictionary);
+	}
+	timeColumn = timeHandle >= 0 ? findColumn(timeHandle) : 0;
+	if (timeHandle >= 0 && ! timeColumn)
+		alert(tr("Time column '%1' not found, using the Path's clock").arg(ColumnNames::name(timeHandle)));
+	// Columns may have changed type, so start over from the next line
+	started = false;
+}
+
+void DeadbandModule::process() {
+	if ( ! passes(-1)) dropLine();
+}
+
+void DeadbandModule::processBatch(int first, int count) {
+	for (int r = first; r < first + count; ++r)
+		processRow(r);
+}
+
+bool DeadbandModule::passes(int row) {
+	bool pass = ! started;
+	qint64 t = 0;
+	if (heartbeatMsecs) {
+		if (timeColumn) t = row < 0 ? timeColumn->toInt() : timeColumn->rowInt(row);
+		else t = getTime().toMSecsSinceEpoch();
+		if (t - lastPassed >= heartbeatMsecs) pass = true;
+	}
+	for (int k = 0, n = channels.size(); ! pass && k < n; ++k)
+		pass = changed(channels.at(k), row);
+	if ( ! pass) return false;
+	started = true;
+	lastPassed = t;
+	for (int k = 0, n = channels.size(); k < n; ++k) {
+		Channel &ch = channels[k];
+		if ( ! ch.column) continue;
+		if (ch.exact && ! ch.column->isNative()) ch.lastText = row < 0 ? ch.column->c : ch.column->rowText.at(row);
+		else ch.last = value(ch.column, row);
+	}
+	return true;
+}
+
+bool DeadbandModule::changed(const Channel &ch, int row) {
+	const Column *c = ch.column;
+	if ( ! c) return false;
+	if (ch.exact && ! c->isNative())
+		return (row < 0 ? c->c : c->rowText.at(row)) != ch.lastText;
+	double v = value(c, row);
+	if (ch.exact) return v != ch.last;
+	if (v != v || ch.last != ch.last) return (v == v) != (ch.last == ch.last);  // Into or out of NaN
+	double d = std::fabs(v - ch.last);
+	return d > ch.absolute && d > ch.relative * std::fabs(ch.last);
+}
+
+double DeadbandModule::value(const Column *c, int row) {
+	// Dictionary indexes compare exactly without looking the strings up
+	if (c->t == Column::Dictionary) return (double) (row < 0 ? c->v.i : c->rows.at(row).i);
+	bool ok;
+	double v = row < 0 ? c->toDouble(&ok) : c->rowDouble(row, &ok);
+	return ok ? v : std::numeric_limits<double>::quiet_NaN();
+}
+
+rapidjson::Value DeadbandModule::publishSettings(rapidjson::MemoryPoolAllocator<> &a) const {
+	Value s(kObjectType);
+	Value columns(kObjectType);
+	columns.AddMember("t", "array", a);
+	columns.AddMember("d", "Columns to monitor, as names or objects with Name, Absolute and Relative", a);
+	s.AddMember("Columns", columns, a);
+	Value absolute(kObjectType);
+	absolute.AddMember("t", "double", a);
+	absolute.AddMember("d", "Change a value must exceed to pass a line", a);
+	s.AddMember("Absolute", absolute, a);
+	Value relative(kObjectType);
+	relative.AddMember("t", "double", a);
+	relative.AddMember("d", "Change a value must exceed to pass a line, as a fraction of the last value passed", a);
+	s.AddMember("Relative", relative, a);
+	Value heartbeat(kObjectType);
+	heartbeat.AddMember("t", "double", a);
+	heartbeat.AddMember("d", "Seconds after which a line passes even if nothing changed", a);
+	s.AddMember("Heartbeat", heartbeat, a);
+	Value time(kObjectType);
+	time.AddMember("t", "string", a);
+	time.AddMember("d", "Timestamp column to time the heartbeat by; the path's clock if unset", a);
+	s.AddMember("Time", time, a);
+	return s;
+}
+
+rapidjson::Value DeadbandModule::publishActions(rapidjson::MemoryPoolAllocator<> &a) const {
+	(void) a;
+	return Value(rapidjson::kNullType);
+}
+
+void DeadbandModule::cleanup() {
+	
+}
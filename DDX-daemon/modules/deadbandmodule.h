@@ -0,0 +1,114 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef DEADBANDMODULE_H
+#define DEADBANDMODULE_H
+
+#include <QObject>
+#include <QVector>
+#include "module.h"
+
+class Path;
+
+/*!
+ * \brief Passes a line on only when monitored Columns change
+ * 
+ * Each monitored Column is compared to its value in the last line passed on.
+ * A line goes on when any of them has moved by more than its deadband, or
+ * when no line has gone on for the heartbeat period; every other line is
+ * dropped before any downstream Module sees it (see Module::dropsLines()).
+ * The first line, and the first after a reconfiguration, always goes on.
+ * 
+ * A numeric Column has changed when the difference exceeds both its
+ * absolute deadband and its relative deadband times the last value passed
+ * on.  With no deadband, any change counts.  Text, Bool and Dictionary
+ * Columns without a deadband are compared exactly, so that states such as
+ * "OPEN" and "CLOSED" need no parsing.
+ * 
+ * ### Settings
+ * - Columns: array of Columns to monitor, each either a name or an object
+ * with a "Name" and optionally "Absolute" and "Relative" deadbands
+ * - Absolute: the absolute deadband of Columns which do not set their own; 0
+ * by default
+ * - Relative: the relative deadband of Columns which do not set their own,
+ * as a fraction; 0 by default
+ * - Heartbeat: seconds after which a line goes on even if nothing changed;
+ * never by default
+ * - Time: name of a Timestamp Column to time the heartbeat by; otherwise the
+ * Path's clock (see Module::getTime())
+ * 
+ * \ingroup modules
+ */
+class DeadbandModule final : public Module
+{
+	Q_OBJECT  // Required
+public:
+	using Module::Module;  // Required
+	~DeadbandModule();  // Required
+	void init(rapidjson::Value &config) override;  // Required
+	void process() override;  // Required
+	void processBatch(int first, int count) override;
+	bool processesBatches() const override {return true;}
+	void processRow(int row) {if ( ! passes(row)) dropRow(row);}  // For fused chains
+	bool dropsLines() const override {return true;}
+	rapidjson::Value publishSettings(rapidjson::MemoryPoolAllocator<> &a) const override;
+	rapidjson::Value publishActions(rapidjson::MemoryPoolAllocator<> &a) const override;
+	void cleanup() override;  // Required
+	void handleReconfigure() override;  // Required
+	
+private:
+	struct Channel {
+		ColumnHandle handle;
+		double absolute;
+		double relative;
+		Column *column;  //!< The monitored Column, or 0 if not found
+		bool exact;  //!< Whether any change counts, comparing text rather than parsing it
+		double last;  //!< The value in the last line passed on
+		QByteArray lastText;  //!< The text in the last line passed on, if #exact text
+	};
+	
+	QVector<Channel> channels;
+	
+	//! Maximum milliseconds between lines passed on, or 0 for no heartbeat
+	qint64 heartbeatMsecs;
+	
+	//! Handle of the Time setting, or -1
+	ColumnHandle timeHandle;
+	
+	Column *timeColumn;
+	
+	//! Whether a line has been passed on since the last reconfiguration
+	bool started;
+	
+	//! Time the last line was passed on
+	qint64 lastPassed;
+	
+	/*!
+	 * \brief Decide whether a line goes on, remembering its values if so
+	 * \param row The batch row, or -1 for the current values
+	 */
+	bool passes(int row);
+	
+	//! Whether \a ch in \a row differs from the last value passed on
+	static inline bool changed(const Channel &ch, int row);
+	
+	//! The value of \a c in \a row, or its current value if \a row is -1; NaN if not a number
+	static inline double value(const Column *c, int row);
+};
+
+#endif // DEADBANDMODULE_H
@@ -0,0 +1,323 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "decimatemodule.h"
+#include "../rapidjson_using.h"
+#include "../daemon_constants.h"
+#include <cmath>
+#include <limits>
+
+static const double missing = std::numeric_limits<double>::quiet_NaN();
+
+//! Twice the signed area of the triangle \a o, \a a, \a b; positive if counter-clockwise
+static inline double cross(double ox, double oy, double ax, double ay, double bx, double by) {
+	return (ax - ox) * (by - oy) - (ay - oy) * (bx - ox);
+}
+
+void DecimateModule::Hull::add(const Point &p) {
+	// Andrew's monotone chain, one point at a time since lines arrive in time order
+	int n = upper.size();
+	while (n >= 2 && cross(upper.at(n - 2).x, upper.at(n - 2).y, upper.at(n - 1).x, upper.at(n - 1).y, p.x, p.y) >= 0)
+		--n;
+	upper.resize(n);
+	upper.append(p);
+	n = lower.size();
+	while (n >= 2 && cross(lower.at(n - 2).x, lower.at(n - 2).y, lower.at(n - 1).x, lower.at(n - 1).y, p.x, p.y) <= 0)
+		--n;
+	lower.resize(n);
+	lower.append(p);
+	QVector<Point> *sides[] = {&upper, &lower};
+	for (int s = 0; s < 2; ++s) {
+		QVector<Point> &h = *sides[s];
+		if (h.size() <= DECIMATE_MAX_HULL) continue;
+		int k = 1;
+		for (int i = 2; i < h.size() - 1; i += 2)
+			h[k++] = h.at(i);
+		h[k++] = h.last();
+		h.resize(k);
+	}
+}
+
+DecimateModule::~DecimateModule() {
+	
+}
+
+void DecimateModule::init(rapidjson::Value &config) {
+	mode = Average;
+	widthMsecs = 1000;
+	timeHandle = -1;
+	timeColumn = 0;
+	batchTime = 0;
+	bucketColumn = 0;
+	if (config.IsObject()) {
+		Value::MemberIterator it = config.FindMember("Columns");
+		if (it != config.MemberEnd() && it->value.IsArray())
+			for (Value::ValueIterator c = it->value.Begin(); c != it->value.End(); ++c)
+				if (c->IsString())
+					handles.append(ColumnNames::intern(QString::fromUtf8(c->GetString(), c->GetStringLength())));
+		it = config.FindMember("Seconds");
+		if (it != config.MemberEnd() && it->value.IsNumber()) {
+			widthMsecs = (qint64) (it->value.GetDouble() * 1000);
+			if (widthMsecs < 1) {
+				alert(tr("Bucket width must be at least a millisecond"));
+				widthMsecs = 1;
+			}
+		}
+		it = config.FindMember("Mode");
+		if (it != config.MemberEnd() && it->value.IsString()) {
+			QByteArray m(it->value.GetString(), it->value.GetStringLength());
+			if (m == "MinMax") mode = MinMax;
+			else if (m == "LTTB") mode = LTTB;
+			else if (m != "Average") alert(tr("Unknown mode '%1', using Average").arg(QString(m)));
+		}
+		it = config.FindMember("Time");
+		if (it != config.MemberEnd() && it->value.IsString())
+			timeHandle = ColumnNames::intern(QString::fromUtf8(it->value.GetString(), it->value.GetStringLength()));
+	}
+	if (handles.isEmpty()) alert(tr("No columns to decimate were configured"));
+	int n = handles.size();
+	line.resize(n);
+	sums.resize(n);
+	sumsX.resize(n);
+	counts.resize(n);
+	minima.resize(n);
+	maxima.resize(n);
+	hulls.resize(n);
+	pendingHulls.resize(n);
+	kept.resize(n);
+	keptValid.fill(false, n);
+	started = false;
+	pendingValid = false;
+	finishing = false;
+	QVector<ColumnHandle> reads(handles);
+	if (timeHandle >= 0) reads.append(timeHandle);
+	declareColumns(reads, QVector<ColumnHandle>());
+}
+
+void DecimateModule::handleReconfigure() {
+	inputs.resize(handles.size());
+	outputs.resize(handles.size());
+	envelope.fill(0, handles.size() * 2);
+	for (int k = 0; k < handles.size(); ++k) {
+		QString name = ColumnNames::name(handles.at(k));
+		Column *in = findColumn(handles.at(k));
+		inputs[k] = in;
+		outputs[k] = 0;
+		if ( ! in) {
+			alert(tr("Column '%1' not found").arg(name));
+			continue;
+		}
+		int index = outputColumns.indexOf(in);
+		removeColumn(in);
+		outputs[k] = insertColumn(handles.at(k), index, Column::Double);
+		if (mode == MinMax) {
+			envelope[k * 2] = insertColumn(name + "_min", index + 1, Column::Double);
+			envelope[k * 2 + 1] = insertColumn(name + "_max", index + 2, Column::Double);
+		}
+	}
+	bucketColumn = insertColumn("Bucket", outputColumns.size(), Column::Timestamp);
+	if ( ! bucketColumn) alert(tr("A column named 'Bucket' already exists"));
+	timeColumn = timeHandle >= 0 ? findColumn(timeHandle) : 0;
+	if (timeHandle >= 0 && ! timeColumn)
+		alert(tr("Time column '%1' not found, using the Path's clock").arg(ColumnNames::name(timeHandle)));
+}
+
+void DecimateModule::process() {
+	for (int k = 0; k < inputs.size(); ++k) {
+		bool ok = false;
+		double x = inputs.at(k) ? inputs.at(k)->toDouble(&ok) : 0;
+		line[k] = ok ? x : missing;
+	}
+	if ( ! take(timeColumn ? timeColumn->toInt() : getTime().toMSecsSinceEpoch(), -1)) dropLine();
+}
+
+void DecimateModule::processBatch(int first, int count) {
+	beginRows(first, count);
+	for (int r = first; r < first + count; ++r)
+		processRow(r);
+}
+
+void DecimateModule::beginRows(int first, int count) {
+	(void) first;
+	(void) count;
+	// Without a time column every line of a batch arrived at about the same time
+	batchTime = timeColumn ? 0 : getTime().toMSecsSinceEpoch();
+}
+
+bool DecimateModule::take(qint64 t, int row) {
+	// Floor division, so that buckets before the epoch line up too
+	qint64 b = t >= 0 ? t / widthMsecs : -((widthMsecs - 1 - t) / widthMsecs);
+	bool carries = false;
+	if ( ! started) {
+		origin = t;
+		started = true;
+		startBucket(b);
+	}
+	else if (b != bucket) {
+		carries = closeBucket(row);
+		startBucket(b);
+	}
+	double x = (double) (t - origin);
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		double y = line.at(k);
+		if (y != y) continue;  // NaN
+		sums[k] += y;
+		sumsX[k] += x;
+		if ( ! counts.at(k)++) minima[k] = maxima[k] = y;
+		else {
+			if (y < minima.at(k)) minima[k] = y;
+			if (y > maxima.at(k)) maxima[k] = y;
+		}
+		if (mode == LTTB) hulls[k].add({x, y});
+	}
+	// Only seen downstream in Paths with branches, which cannot drop the line
+	if ( ! carries) blank(row);
+	return carries;
+}
+
+bool DecimateModule::finishStream() {
+	if ( ! started) return false;
+	// LTTB closes the pending bucket first, then the last one against its own last value
+	bool last = mode != LTTB || finishing;
+	finishing = ! last;
+	bool carries = closeBucket(-1);
+	startBucket(bucket);
+	if (last) {
+		started = false;
+		pendingValid = false;
+		for (int k = 0; k < keptValid.size(); ++k)
+			keptValid[k] = false;
+	}
+	// With only one bucket there was nothing pending to carry
+	return carries || ( ! last && finishStream());
+}
+
+bool DecimateModule::closeBucket(int row) {
+	int n = line.size();
+	if (mode != LTTB) {
+		for (int k = 0; k < n; ++k) {
+			qint64 c = counts.at(k);
+			put(outputs.at(k), row, c ? sums.at(k) / c : missing);
+			if (mode == MinMax) {
+				put(envelope.at(k * 2), row, c ? minima.at(k) : missing);
+				put(envelope.at(k * 2 + 1), row, c ? maxima.at(k) : missing);
+			}
+		}
+		if (bucketColumn && bucketColumn->live) {
+			if (row < 0) bucketColumn->setTimestamp(bucket * widthMsecs);
+			else bucketColumn->rows[row].i = bucket * widthMsecs;
+		}
+		return true;
+	}
+	bool carries = pendingValid;
+	if (carries) {
+		for (int k = 0; k < n; ++k) {
+			const Hull &h = pendingHulls.at(k);
+			if (h.upper.isEmpty()) {
+				put(outputs.at(k), row, missing);
+				continue;
+			}
+			// The third corner is the mean of the bucket after, or failing that the last value
+			Point c = counts.at(k) ? Point{sumsX.at(k) / counts.at(k), sums.at(k) / counts.at(k)} : h.upper.last();
+			Point a = keptValid.at(k) ? kept.at(k) : h.upper.first();
+			Point best = h.upper.first();
+			double bestArea = -1;
+			const QVector<Point> *sides[] = {&h.upper, &h.lower};
+			for (int s = 0; s < 2; ++s)
+				for (int i = 0; i < sides[s]->size(); ++i) {
+					const Point &p = sides[s]->at(i);
+					double area = std::fabs(cross(a.x, a.y, p.x, p.y, c.x, c.y));
+					if (area > bestArea) {
+						bestArea = area;
+						best = p;
+					}
+				}
+			kept[k] = best;
+			keptValid[k] = true;
+			put(outputs.at(k), row, best.y);
+		}
+		if (bucketColumn && bucketColumn->live) {
+			if (row < 0) bucketColumn->setTimestamp(pendingBucket * widthMsecs);
+			else bucketColumn->rows[row].i = pendingBucket * widthMsecs;
+		}
+	}
+	// The bucket just finished now waits for the mean of the next one
+	pendingHulls.swap(hulls);
+	pendingBucket = bucket;
+	pendingValid = true;
+	return carries;
+}
+
+void DecimateModule::blank(int row) {
+	for (int k = 0, n = outputs.size(); k < n; ++k)
+		put(outputs.at(k), row, missing);
+	for (int k = 0, n = envelope.size(); k < n; ++k)
+		put(envelope.at(k), row, missing);
+	if (bucketColumn && bucketColumn->live) {
+		if (row < 0) bucketColumn->setTimestamp(bucket * widthMsecs);
+		else bucketColumn->rows[row].i = bucket * widthMsecs;
+	}
+}
+
+void DecimateModule::startBucket(qint64 b) {
+	bucket = b;
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		sums[k] = 0;
+		sumsX[k] = 0;
+		counts[k] = 0;
+		hulls[k].clear();
+	}
+}
+
+void DecimateModule::put(Column *c, int row, double v) {
+	if ( ! c || ! c->live) return;
+	if (row < 0) c->setDouble(v);
+	else c->rows[row].d = v;
+}
+
+rapidjson::Value DecimateModule::publishSettings(rapidjson::MemoryPoolAllocator<> &a) const {
+	Value s(kObjectType);
+	Value columns(kObjectType);
+	columns.AddMember("t", "array", a);
+	columns.AddMember("d", "Names of the columns to decimate", a);
+	s.AddMember("Columns", columns, a);
+	Value seconds(kObjectType);
+	seconds.AddMember("t", "double", a);
+	seconds.AddMember("d", "Bucket width in seconds", a);
+	seconds.AddMember("default", 1, a);
+	s.AddMember("Seconds", seconds, a);
+	Value mode(kObjectType);
+	mode.AddMember("t", "string", a);
+	mode.AddMember("d", "Average, MinMax or LTTB", a);
+	mode.AddMember("default", "Average", a);
+	s.AddMember("Mode", mode, a);
+	Value time(kObjectType);
+	time.AddMember("t", "string", a);
+	time.AddMember("d", "Timestamp column to bucket lines by; the path's clock if unset", a);
+	s.AddMember("Time", time, a);
+	return s;
+}
+
+rapidjson::Value DecimateModule::publishActions(rapidjson::MemoryPoolAllocator<> &a) const {
+	(void) a;
+	return Value(rapidjson::kNullType);
+}
+
+void DecimateModule::cleanup() {
+	
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef DECIMATEMODULE_H
+#define DECIMATEMODULE_H
+
+#include <QObject>
+#include <QVector>
+#include <limits>
+#include "module.h"
+
+class Path;
+
+/*!
+ * \brief Reduces a fast stream to one line per time bucket
+ * 
+ * Lines are grouped into buckets of a fixed width, aligned to the epoch, and
+ * only one line per bucket goes on; every other line is dropped (see
+ * Module::dropsLines()).  The line which goes on is the first line of the
+ * next bucket, which carries the results for the bucket it closed.  Each
+ * configured Column is replaced by a Double Column of the same name, and a
+ * Timestamp Column named "Bucket" with the start of the bucket is inserted.
+ * Other Columns keep the values of the line carrying the results.  Paths
+ * with branches cannot drop lines, so there every line goes on, and the
+ * lines between carriers have NaN results and their own bucket's start.
+ * When a finite stream ends, the buckets still open are closed onto lines
+ * of their own, whose other Columns keep the values they last had.
+ * 
+ * ### Modes
+ * - Average: the mean of the bucket
+ * - MinMax: the mean, plus the envelope in inserted Columns named after
+ * the Column with "_min" and "_max", so that no peak is lost
+ * - LTTB: Largest-Triangle-Three-Buckets, which keeps the value in each
+ * bucket forming the largest triangle with the value kept for the bucket
+ * before and the mean of the bucket after.  Results therefore arrive one
+ * bucket later than in the other modes, and each Column picks its own value.
+ * 
+ * Memory does not grow with the number of lines in a bucket.  The LTTB
+ * choice always lies on the convex hull of a bucket's values, so only the
+ * hull is kept, built incrementally as lines arrive in time order.  Hulls
+ * longer than #DECIMATE_MAX_HULL points are thinned, which may cost
+ * LTTB some accuracy on long, smoothly curving buckets.
+ * 
+ * ### Settings
+ * - Columns: array of the names of the Columns to decimate
+ * - Seconds: the bucket width in seconds; 1 by default
+ * - Mode: "Average" (the default), "MinMax" or "LTTB"
+ * - Time: name of a Timestamp Column to bucket lines by; otherwise the Path's
+ * clock (see Module::getTime())
+ * 
+ * \ingroup modules
+ */
+class DecimateModule final : public Module
+{
+	Q_OBJECT  // Required
+public:
+	using Module::Module;  // Required
+	~DecimateModule();  // Required
+	void init(rapidjson::Value &config) override;  // Required
+	void process() override;  // Required
+	void processBatch(int first, int count) override;
+	bool processesBatches() const override {return true;}
+	void beginRows(int first, int count);  // For fused chains
+	inline void processRow(int row);  // For fused chains
+	bool dropsLines() const override {return true;}
+	bool finishStream() override;
+	rapidjson::Value publishSettings(rapidjson::MemoryPoolAllocator<> &a) const override;
+	rapidjson::Value publishActions(rapidjson::MemoryPoolAllocator<> &a) const override;
+	void cleanup() override;  // Required
+	void handleReconfigure() override;  // Required
+	
+private:
+	enum Mode {Average, MinMax, LTTB};
+	
+	struct Point {
+		double x;  //!< Milliseconds since #origin
+		double y;
+	};
+	
+	//! Upper and lower convex hulls of the values of one Column in one bucket
+	struct Hull {
+		QVector<Point> upper;
+		QVector<Point> lower;
+		void clear() {upper.resize(0); lower.resize(0);}
+		void add(const Point &p);
+	};
+	
+	Mode mode;
+	
+	qint64 widthMsecs;
+	
+	QVector<ColumnHandle> handles;
+	
+	//! Handle of the Time setting, or -1
+	ColumnHandle timeHandle;
+	
+	QVector<Column*> inputs;
+	
+	Column *timeColumn;
+	
+	//! The replacement Columns, one per configured Column
+	QVector<Column*> outputs;
+	
+	//! MinMax only: the envelope Columns, two per configured Column
+	QVector<Column*> envelope;
+	
+	Column *bucketColumn;
+	
+	//! Whether a bucket has been started
+	bool started;
+	
+	//! Index of the bucket being filled
+	qint64 bucket;
+	
+	//! Time of the first line, which LTTB measures from
+	qint64 origin;
+	
+	// The bucket being filled, per configured Column
+	QVector<double> sums;
+	QVector<double> sumsX;
+	QVector<qint64> counts;
+	QVector<double> minima;
+	QVector<double> maxima;
+	QVector<Hull> hulls;
+	
+	// LTTB only: the bucket waiting for the mean of the one being filled
+	bool pendingValid;
+	qint64 pendingBucket;
+	QVector<Hull> pendingHulls;
+	
+	//! LTTB only: whether finishStream() has the last bucket still to close
+	bool finishing;
+	
+	// LTTB only: the value kept from the last bucket, per configured Column
+	QVector<Point> kept;
+	QVector<bool> keptValid;
+	
+	//! Scratch values of the current line, one per configured Column
+	QVector<double> line;
+	
+	//! The clock as of beginRows(), for lines without a time of their own
+	qint64 batchTime;
+	
+	/*!
+	 * \brief Add the values in #line at time \a t to their bucket
+	 * \param row The batch row, or -1 for the current values
+	 * \return Whether the line carries results and should go on
+	 */
+	bool take(qint64 t, int row);
+	
+	//! Write the results of the finished bucket to \a row; returns whether there were any
+	bool closeBucket(int row);
+	
+	//! Write NaN results to \a row, which carries none
+	void blank(int row);
+	
+	//! Empty the bucket being filled
+	void startBucket(qint64 b);
+	
+	//! Set \a c in \a row, or its current value if \a row is -1
+	static inline void put(Column *c, int row, double v);
+};
+
+void DecimateModule::processRow(int row) {
+	for (int k = 0, n = inputs.size(); k < n; ++k) {
+		bool ok = false;
+		double x = inputs.at(k) ? inputs.at(k)->rowDouble(row, &ok) : 0;
+		line[k] = ok ? x : std::numeric_limits<double>::quiet_NaN();
+	}
+	if ( ! take(timeColumn ? timeColumn->rowInt(row) : batchTime, row)) dropRow(row);
+}
+
+#endif // DECIMATEMODULE_H
@@ -18,6 +18,8 @@
 
 #include "exampleinlet.h"
 #include "rapidjson_using.h"
+#include "numberformat.h"
+#include <cstring>
 
 ExampleInlet::ExampleInlet(Path *parent, const QByteArray &name) : Inlet(parent, name) {
 	std::seed_seq ss({210, QTime::currentTime().msec(), 34});
@@ -38,16 +40,16 @@ void ExampleInlet::init(rapidjson::Value &config) {
 	QVariantList tl = config["items"].toArray().toVariantList();
 	foreach (const QVariant &timerEntry, tl) {
 		QJsonObject te = timerEntry.toJsonObject();
-		QTimer *t = new QTimer(this);
+		ClockTimer *t = new ClockTimer(path->getClock(), this);
 		t->setInterval(te["Interval"].toInt(10000));
-		connect(t, &QTimer::timeout, this, &ExampleInlet::trigger);
+		connect(t, &ClockTimer::timeout, this, &ExampleInlet::trigger);
 		timers.append(t);
 	}
-	ctColumn = insertColumn("Index", 0);
-	randColumn = insertColumn("Random", 1);
-	QByteArray *dummyPtr = insertColumn("Dummy", 2);
+	ctColumn = insertColumn("Index", 0, Column::Int64);
+	randColumn = insertColumn("Random", 1, Column::Int64);
+	Column *dummyPtr = insertColumn("Dummy", 2);
 	QByteArray dummy = config["Dummy_string"].toString().toUtf8();
-	*dummyPtr = dummy;*/
+	dummyPtr->setText(dummy);*/
 }
 
 void ExampleInlet::start() {
@@ -86,7 +88,7 @@ void ExampleInlet::trigger() {
 	int n = abs((int) rg()) % 100;
 	if (n <= chance) {
 		if (outputColumns.size() == 3) {
-			inColumn = &insertColumn("Inserted",2)->c;
+			inColumn = insertColumn("Inserted",2);
 			ct2 = 0;
 		}
 		else {
@@ -95,9 +97,20 @@ void ExampleInlet::trigger() {
 		}
 		path->reconfigure();
 	}
-	*ctColumn = QByteArray::number(++ct);
-	*randColumn = QByteArray::number(rg());
-	if (inColumn)
-		*inColumn = QString("Inserted %1 lines ago").arg(ct2++).toUtf8();
+	ctColumn->setInt(++ct);
+	if (randColumn->live) randColumn->setInt(rg());
+	// Lines a downstream filter would drop are not worth finishing
+	if ( ! passesPushdown()) return;
+	if (inColumn) {
+		// Formatting is only worth doing if someone downstream reads it
+		if (inColumn->live) {
+			char s[NUMBER_FORMAT_MAX + 20];
+			memcpy(s, "Inserted ", 9);
+			int n = 9 + NumberFormat::formatInt(ct2, s + 9);
+			memcpy(s + n, " lines ago", 10);
+			inColumn->setText(s, n + 10);
+		}
+		ct2++;
+	}
 	process();
 }
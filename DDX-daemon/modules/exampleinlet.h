@@ -22,10 +22,10 @@
 #include <QObject>
 #include <QList>
 #include <QTime>
-#include <QTimer>
 #include <QVariant>
 #include <random>
 #include "inlet.h"
+#include "pathclock.h"
 
 class Path;
 
@@ -54,11 +54,11 @@ private slots:
 private:
 	std::mt19937 rg;
 	bool allowReconfigure;
-	QList<QTimer*> timers;
+	QList<ClockTimer*> timers;
 	int chance;
 	bool failOnInit;
 	int ct, ct2;
-	QByteArray *ctColumn, *randColumn, *inColumn;
+	Column *ctColumn, *randColumn, *inColumn;
 };
 
 #endif // EXAMPLEINLET_H
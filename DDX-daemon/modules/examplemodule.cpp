@@ -37,6 +37,11 @@ void ExampleModule::process() {
 	alert(echo);
 }
 
+void ExampleModule::processBatch(int first, int count) {
+	for (int i = first; i < first + count; ++i)
+		processRow(i);
+}
+
 rapidjson::Value ExampleModule::publishSettings(rapidjson::MemoryPoolAllocator<> &a) const {
 	alert("ExampleModule::publishSettings()");
 	// TODO:  rapidjson this
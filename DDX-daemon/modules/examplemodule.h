@@ -37,6 +37,9 @@ public:
 	~ExampleModule();  // Required
 	void init(rapidjson::Value &config) override;  // Required
 	void process() override;  // Required
+	void processBatch(int first, int count) override;  // Optional
+	bool processesBatches() const override {return true;}  // Optional
+	void processRow(int row) {(void) row; alert(echo);}  // Optional; for fused chains
 	rapidjson::Value publishSettings(rapidjson::MemoryPoolAllocator<> &a) const override;  // Optional
 	rapidjson::Value publishActions(rapidjson::MemoryPoolAllocator<> &a) const override;  // Optional
 	void cleanup() override;  // Required
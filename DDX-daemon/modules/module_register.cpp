@@ -19,15 +19,31 @@
 #ifndef MODULE_REGISTER_CPP
 #define MODULE_REGISTER_CPP
 #include "../pathmanager.h"
+#include "../fusedchain.h"
 
 // Include Module headers here
 #include "examplemodule.h"
 #include "exampleinlet.h"
+#include "parsemodule.h"
+#include "windowmodule.h"
+#include "decimatemodule.h"
+#include "deadbandmodule.h"
 
 void PathManager::registerModules() {
 	// List all Modules here (1 of 2)
 	modules.insert("ExampleModule", ExampleModule::staticMetaObject);
 	modules.insert("ExampleInlet", ExampleInlet::staticMetaObject);
+	modules.insert("ParseModule", ParseModule::staticMetaObject);
+	modules.insert("WindowModule", WindowModule::staticMetaObject);
+	modules.insert("DecimateModule", DecimateModule::staticMetaObject);
+	modules.insert("DeadbandModule", DeadbandModule::staticMetaObject);
+	
+	// List fused chains of the Modules above here (see FusedChainOf)
+	registerFusedChain<ParseModule, WindowModule>();
+	registerFusedChain<ParseModule, WindowModule, DecimateModule>();
+	registerFusedChain<ParseModule, DecimateModule>();
+	registerFusedChain<ParseModule, DeadbandModule>();
+	registerFusedChain<WindowModule, DecimateModule>();
 }
 
 QMap<QString, QString> PathManager::getModuleDescriptions() const {
@@ -36,6 +52,10 @@ QMap<QString, QString> PathManager::getModuleDescriptions() const {
 	// List all Modules here (2 of 2)
 	m.insert("ExampleModule", tr("An example module"));
 	m.insert("ExampleInlet", tr("An example inlet"));
+	m.insert("ParseModule", tr("Converts text columns to numbers"));
+	m.insert("WindowModule", tr("Rolling statistics of columns over a window of lines or time"));
+	m.insert("DecimateModule", tr("Downsample columns to one line per time bucket by mean, envelope or LTTB"));
+	m.insert("DeadbandModule", tr("Pass lines on only when columns change beyond a deadband or a heartbeat expires"));
 	
 	return m;
 }
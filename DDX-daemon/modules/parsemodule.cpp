@@ -0,0 +1,250 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "parsemodule.h"
+#include "../rapidjson_using.h"
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+//! Exactly representable powers of ten, for the fast path of parseDouble()
+static const double powersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//! Whether all eight bytes of \a v are ASCII digits
+static inline bool isEightDigits(quint64 v) {
+	return ((v & Q_UINT64_C(0xF0F0F0F0F0F0F0F0))
+			| (((v + Q_UINT64_C(0x0606060606060606)) & Q_UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4))
+			== Q_UINT64_C(0x3333333333333333);
+}
+
+//! The value of eight ASCII digits loaded little-endian into \a v
+static inline quint64 eightDigitsValue(quint64 v) {
+	v -= Q_UINT64_C(0x3030303030303030);
+	v = (v * 10) + (v >> 8);
+	v = (((v & Q_UINT64_C(0x000000FF000000FF)) * (100 + (Q_UINT64_C(1000000) << 32)))
+		 + (((v >> 16) & Q_UINT64_C(0x000000FF000000FF)) * (1 + (Q_UINT64_C(10000) << 32)))) >> 32;
+	return v;
+}
+
+/*!
+ * \brief Accumulate a run of digits
+ * \return The number of digits read
+ * 
+ * Digits beyond the 19th wrap \a value; callers check the count.
+ */
+static inline int readDigits(const char *&p, const char *end, quint64 &value) {
+	const char *start = p;
+	while (end - p >= 8) {
+		quint64 v;
+		memcpy(&v, p, 8);
+		v = qFromLittleEndian(v);
+		if ( ! isEightDigits(v)) break;
+		value = value * 100000000 + eightDigitsValue(v);
+		p += 8;
+	}
+	while (p < end && *p >= '0' && *p <= '9') {
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+	return (int) (p - start);
+}
+
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//! Trim whitespace from both ends of [\a p, \a end)
+static inline void trim(const char *&p, const char *&end) {
+	while (p < end && isSpace(*p)) ++p;
+	while (end > p && isSpace(end[-1])) --end;
+}
+
+ParseModule::~ParseModule() {
+	qDeleteAll(malformedCounts);
+}
+
+void ParseModule::init(rapidjson::Value &config) {
+	type = Column::Double;
+	if ( ! config.IsObject()) return;
+	Value::MemberIterator it = config.FindMember("Columns");
+	if (it != config.MemberEnd() && it->value.IsArray()) {
+		for (Value::ValueIterator c = it->value.Begin(); c != it->value.End(); ++c) {
+			if ( ! c->IsString()) {
+				alert(tr("Column names must be strings"));
+				continue;
+			}
+			handles.append(ColumnNames::intern(QString::fromUtf8(c->GetString(), c->GetStringLength())));
+		}
+	}
+	if (handles.isEmpty()) alert(tr("No columns to parse were configured"));
+	it = config.FindMember("Type");
+	if (it != config.MemberEnd() && it->value.IsString()) {
+		QByteArray t(it->value.GetString(), it->value.GetStringLength());
+		if (t == "Int64") type = Column::Int64;
+		else if (t != "Double") alert(tr("Unknown type '%1', using Double").arg(QString(t)));
+	}
+	declareColumns(handles, QVector<ColumnHandle>());
+}
+
+void ParseModule::handleReconfigure() {
+	conversions.resize(0);
+	for (int i = 0; i < handles.size(); ++i) {
+		Column *in = findColumn(handles.at(i));
+		if ( ! in) {
+			alert(tr("Column '%1' not found").arg(ColumnNames::name(handles.at(i))));
+			continue;
+		}
+		if (in->isNative()) continue;
+		int index = outputColumns.indexOf(in);
+		removeColumn(in);
+		Conversion c;
+		c.in = in;
+		c.out = insertColumn(handles.at(i), index, type);
+		if ( ! c.out) continue;
+		c.malformed = malformedCounts.value(handles.at(i), 0);
+		if ( ! c.malformed) {
+			c.malformed = new QAtomicInteger<quint64>(0);
+			malformedCounts.insert(handles.at(i), c.malformed);
+		}
+		conversions.append(c);
+	}
+}
+
+void ParseModule::process() {
+	bool ok;
+	for (int i = 0; i < conversions.size(); ++i) {
+		const Conversion &c = conversions.at(i);
+		if ( ! c.out->live) continue;
+		if (type == Column::Int64) c.out->setInt(parseInt(c.in->c.constData(), c.in->c.size(), &ok));
+		else c.out->setDouble(parseDouble(c.in->c.constData(), c.in->c.size(), &ok));
+		if ( ! ok) reportMalformed(c, 1, c.in->c);
+	}
+}
+
+void ParseModule::processBatch(int first, int count) {
+	// Only rows and the shared counters are touched, as isStateless() requires
+	for (int i = 0; i < conversions.size(); ++i) {
+		const Conversion &c = conversions.at(i);
+		if ( ! c.out->live) continue;
+		const QByteArray *text = c.in->rowText.constData();
+		Column::Value *rows = c.out->rows.data();
+		quint64 bad = 0;
+		int lastBad = -1;
+		bool ok;
+		for (int r = first; r < first + count; ++r) {
+			if (type == Column::Int64) rows[r].i = parseInt(text[r].constData(), text[r].size(), &ok);
+			else rows[r].d = parseDouble(text[r].constData(), text[r].size(), &ok);
+			if ( ! ok) {
+				++bad;
+				lastBad = r;
+			}
+		}
+		if (bad) reportMalformed(c, bad, text[lastBad]);
+	}
+}
+
+void ParseModule::reportMalformed(const Conversion &c, quint64 bad, const QByteArray &example) const {
+	quint64 before = c.malformed->fetchAndAddRelaxed(bad);
+	quint64 after = before + bad;
+	// Report at 1, 2, 4, 8... so that a bad instrument cannot flood Beacons
+	quint64 mark = 1;
+	while (mark <= before) mark <<= 1;
+	if (mark > after) return;
+	alert(tr("%1 malformed values in column '%2' so far, most recently '%3'")
+		  .arg(after).arg(c.out->n, QString::fromUtf8(example.left(64))));
+}
+
+double ParseModule::parseDouble(const char *s, int n, bool *ok) {
+	const char *p = s, *end = s + n;
+	trim(p, end);
+	const char *start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	quint64 mantissa = 0;
+	int digits = readDigits(p, end, mantissa);
+	int exponent = 0;
+	if (p < end && *p == '.') {
+		++p;
+		int fraction = readDigits(p, end, mantissa);
+		digits += fraction;
+		exponent -= fraction;
+	}
+	bool valid = digits > 0;
+	if (valid && p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+')) negativeExponent = *p++ == '-';
+		quint64 e = 0;
+		int eDigits = readDigits(p, end, e);
+		if ( ! eDigits || eDigits > 4) valid = false;
+		else exponent += negativeExponent ? -(int) e : (int) e;
+	}
+	if (valid && p == end && digits <= 19 && mantissa <= (Q_UINT64_C(1) << 53)
+			&& exponent >= -22 && exponent <= 22) {
+		// Both operands are exact, so the one rounding gives the correct result
+		double d = (double) mantissa;
+		d = exponent < 0 ? d / powersOfTen[-exponent] : d * powersOfTen[exponent];
+		*ok = true;
+		return negative ? -d : d;
+	}
+	// Long, extreme or unusual forms such as "inf"
+	double d = QByteArray::fromRawData(start, (int) (end - start)).toDouble(ok);
+	return *ok ? d : std::numeric_limits<double>::quiet_NaN();
+}
+
+qint64 ParseModule::parseInt(const char *s, int n, bool *ok) {
+	const char *p = s, *end = s + n;
+	trim(p, end);
+	const char *start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	quint64 value = 0;
+	int digits = readDigits(p, end, value);
+	if (digits && digits <= 18 && p == end) {
+		*ok = true;
+		return negative ? -(qint64) value : (qint64) value;
+	}
+	qint64 i = QByteArray::fromRawData(start, (int) (end - start)).toLongLong(ok);
+	return *ok ? i : 0;
+}
+
+rapidjson::Value ParseModule::publishSettings(rapidjson::MemoryPoolAllocator<> &a) const {
+	Value s(kObjectType);
+	Value columns(kObjectType);
+	columns.AddMember("t", "array", a);
+	columns.AddMember("d", "Names of the text columns to convert", a);
+	s.AddMember("Columns", columns, a);
+	Value t(kObjectType);
+	t.AddMember("t", "string", a);
+	t.AddMember("d", "Double or Int64", a);
+	t.AddMember("default", "Double", a);
+	s.AddMember("Type", t, a);
+	return s;
+}
+
+rapidjson::Value ParseModule::publishActions(rapidjson::MemoryPoolAllocator<> &a) const {
+	(void) a;
+	return Value(rapidjson::kNullType);
+}
+
+void ParseModule::cleanup() {
+	
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef PARSEMODULE_H
+#define PARSEMODULE_H
+
+#include <QObject>
+#include <QVector>
+#include <QAtomicInteger>
+#include <QHash>
+#include "module.h"
+
+class Path;
+
+/*!
+ * \brief Converts text Columns to native numbers in bulk
+ * 
+ * Each configured Column which arrives as text is replaced, at the same
+ * position and under the same name, by a Double or Int64 Column, so that
+ * every Module downstream reads native values instead of parsing text on
+ * its own.  Columns which are already native are passed through untouched.
+ * 
+ * Digits are parsed eight at a time within a 64-bit register.  A decimal
+ * number whose digits, read as an integer, are at most 2^53 (about 15 to 16
+ * significant digits), and whose power of ten is within 10^-22 to 10^22
+ * once the point is removed, converts exactly without calling into the C
+ * library; anything else falls back to QByteArray::toDouble().  Malformed values become NaN (or 0 for
+ * integers) and are counted and reported with alert(), at most once every
+ * time a Column's count doubles, without interrupting the stream.
+ * 
+ * ### Settings
+ * - Columns: array of the names of the Columns to convert
+ * - Type: "Double" (the default) or "Int64"
+ * 
+ * \ingroup modules
+ */
+class ParseModule final : public Module
+{
+	Q_OBJECT  // Required
+public:
+	using Module::Module;  // Required
+	~ParseModule();  // Required
+	void init(rapidjson::Value &config) override;  // Required
+	void process() override;  // Required
+	void processBatch(int first, int count) override;
+	bool processesBatches() const override {return true;}
+	bool isStateless() const override {return true;}
+	inline void processRow(int row);  // For fused chains
+	rapidjson::Value publishSettings(rapidjson::MemoryPoolAllocator<> &a) const override;
+	rapidjson::Value publishActions(rapidjson::MemoryPoolAllocator<> &a) const override;
+	void cleanup() override;  // Required
+	void handleReconfigure() override;  // Required
+	
+	/*!
+	 * \brief Parse a decimal number
+	 * \param s The text, which may be surrounded by whitespace
+	 * \param n Its length
+	 * \param ok Set to whether it was a well-formed number
+	 * \return The value, or NaN if malformed
+	 */
+	static double parseDouble(const char *s, int n, bool *ok);
+	
+	//! Identical to parseDouble() but for integers, returning 0 if malformed
+	static qint64 parseInt(const char *s, int n, bool *ok);
+	
+private:
+	struct Conversion {
+		Column *in;
+		Column *out;
+		//! Malformed values seen; shared by every row range
+		QAtomicInteger<quint64> *malformed;
+	};
+	
+	//! Handles of the Columns to convert, from the settings
+	QVector<ColumnHandle> handles;
+	
+	Column::Type type;
+	
+	QVector<Conversion> conversions;
+	
+	//! Malformed counts by handle, kept across reconfigures
+	QHash<ColumnHandle, QAtomicInteger<quint64>*> malformedCounts;
+	
+	//! Count \a bad more malformed values in \a c, reporting as described above
+	void reportMalformed(const Conversion &c, quint64 bad, const QByteArray &example) const;
+};
+
+void ParseModule::processRow(int row) {
+	bool ok;
+	for (int i = 0, n = conversions.size(); i < n; ++i) {
+		const Conversion &c = conversions.at(i);
+		if ( ! c.out->live) continue;
+		const QByteArray &text = c.in->rowText.at(row);
+		if (type == Column::Int64) c.out->rows[row].i = parseInt(text.constData(), text.size(), &ok);
+		else c.out->rows[row].d = parseDouble(text.constData(), text.size(), &ok);
+		if ( ! ok) reportMalformed(c, 1, text);
+	}
+}
+
+#endif // PARSEMODULE_H
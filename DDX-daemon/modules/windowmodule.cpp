@@ -0,0 +1,295 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "windowmodule.h"
+#include "../rapidjson_using.h"
+#include <cmath>
+#include <limits>
+
+//! Suffixes of the inserted Columns, by WindowModule::Statistic
+static const char *const statisticNames[] = {"mean", "min", "max", "stddev"};
+
+static const double missing = std::numeric_limits<double>::quiet_NaN();
+
+void WindowModule::Deque::reserve(int capacity) {
+	QVector<qint64> grown(capacity);
+	for (int i = 0; i < count; ++i)
+		grown[i] = seqs.at((head + i) & (seqs.size() - 1));
+	seqs = grown;
+	head = 0;
+}
+
+WindowModule::~WindowModule() {
+	
+}
+
+void WindowModule::init(rapidjson::Value &config) {
+	timeHandle = -1;
+	windowLines = 0;
+	windowMsecs = 0;
+	timeColumn = 0;
+	batchTime = 0;
+	for (int s = 0; s < StatisticCount; ++s)
+		wanted[s] = true;
+	if (config.IsObject()) {
+		Value::MemberIterator it = config.FindMember("Columns");
+		if (it != config.MemberEnd() && it->value.IsArray())
+			for (Value::ValueIterator c = it->value.Begin(); c != it->value.End(); ++c)
+				if (c->IsString())
+					handles.append(ColumnNames::intern(QString::fromUtf8(c->GetString(), c->GetStringLength())));
+		it = config.FindMember("Window");
+		if (it != config.MemberEnd() && it->value.IsInt()) windowLines = it->value.GetInt();
+		it = config.FindMember("Seconds");
+		if (it != config.MemberEnd() && it->value.IsNumber())
+			windowMsecs = (qint64) (it->value.GetDouble() * 1000);
+		it = config.FindMember("Time");
+		if (it != config.MemberEnd() && it->value.IsString())
+			timeHandle = ColumnNames::intern(QString::fromUtf8(it->value.GetString(), it->value.GetStringLength()));
+		it = config.FindMember("Statistics");
+		if (it != config.MemberEnd() && it->value.IsArray()) {
+			for (int s = 0; s < StatisticCount; ++s)
+				wanted[s] = false;
+			for (Value::ValueIterator c = it->value.Begin(); c != it->value.End(); ++c) {
+				QByteArray name = c->IsString() ? QByteArray(c->GetString()).toLower() : QByteArray();
+				int s = 0;
+				while (s < StatisticCount && name != statisticNames[s]) ++s;
+				if (s < StatisticCount) wanted[s] = true;
+				else alert(tr("Unknown statistic '%1'").arg(QString(name)));
+			}
+		}
+	}
+	if (handles.isEmpty()) alert(tr("No columns to aggregate were configured"));
+	if (windowLines > 0) windowMsecs = 0;
+	else if (windowMsecs > 0) windowLines = 0;
+	else {
+		alert(tr("No window length was configured, using 60 lines"));
+		windowLines = 60;
+	}
+	capacity = 64;
+	while (capacity < windowLines) capacity <<= 1;
+	line.resize(handles.size());
+	counts.resize(handles.size());
+	means.resize(handles.size());
+	m2s.resize(handles.size());
+	minima.resize(handles.size());
+	maxima.resize(handles.size());
+	reset();
+	QVector<ColumnHandle> reads(handles);
+	if (timeHandle >= 0) reads.append(timeHandle);
+	declareColumns(reads, QVector<ColumnHandle>());
+}
+
+void WindowModule::handleReconfigure() {
+	inputs.resize(handles.size());
+	outputs.resize(handles.size() * StatisticCount);
+	for (int k = 0; k < handles.size(); ++k) {
+		QString name = ColumnNames::name(handles.at(k));
+		inputs[k] = findColumn(handles.at(k));
+		if ( ! inputs.at(k)) alert(tr("Column '%1' not found").arg(name));
+		for (int s = 0; s < StatisticCount; ++s)
+			outputs[k * StatisticCount + s] = wanted[s] ?
+						insertColumn(QString("%1_%2").arg(name, statisticNames[s]), outputColumns.size(), Column::Double) : 0;
+	}
+	timeColumn = timeHandle >= 0 ? findColumn(timeHandle) : 0;
+	if (timeHandle >= 0 && ! timeColumn)
+		alert(tr("Time column '%1' not found, using the Path's clock").arg(ColumnNames::name(timeHandle)));
+}
+
+void WindowModule::process() {
+	for (int k = 0; k < inputs.size(); ++k) {
+		bool ok = false;
+		double x = inputs.at(k) ? inputs.at(k)->toDouble(&ok) : 0;
+		line[k] = ok ? x : missing;
+	}
+	qint64 t = 0;
+	if (timeColumn) t = timeColumn->toInt();
+	else if ( ! windowLines) t = getTime().toMSecsSinceEpoch();
+	update(t, -1);
+}
+
+void WindowModule::processBatch(int first, int count) {
+	beginRows(first, count);
+	for (int r = first; r < first + count; ++r)
+		processRow(r);
+}
+
+void WindowModule::beginRows(int first, int count) {
+	(void) first;
+	(void) count;
+	// Without a time column every line of a batch arrived at about the same time
+	batchTime = timeColumn || windowLines ? 0 : getTime().toMSecsSinceEpoch();
+}
+
+void WindowModule::update(qint64 t, int row) {
+	if (windowLines) {
+		while (next - oldest >= windowLines) evict();
+	}
+	else if (next - oldest == capacity) grow();
+	int mask = capacity - 1;
+	int slot = (int) (next & mask);
+	times[slot] = t;
+	double *v = values.data();
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		double x = line.at(k);
+		v[k * capacity + slot] = x;
+		if (x != x) continue;  // NaN
+		double d = x - means.at(k);
+		means[k] += d / ++counts[k];
+		m2s[k] += d * (x - means.at(k));
+		// Values which can never be the extreme again leave the deques
+		Deque &lo = minima[k];
+		while (lo.count && v[k * capacity + (lo.back() & mask)] >= x) lo.popBack();
+		lo.pushBack(next);
+		Deque &hi = maxima[k];
+		while (hi.count && v[k * capacity + (hi.back() & mask)] <= x) hi.popBack();
+		hi.pushBack(next);
+	}
+	++next;
+	if ( ! windowLines)
+		while (oldest < next && times.at(oldest & mask) <= t - windowMsecs) evict();
+	if (++sinceResync >= next - oldest) resync();
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		double stat[StatisticCount];
+		qint64 c = counts.at(k);
+		stat[Mean] = c ? means.at(k) : missing;
+		stat[Min] = minima.at(k).count ? v[k * capacity + (minima.at(k).front() & mask)] : missing;
+		stat[Max] = maxima.at(k).count ? v[k * capacity + (maxima.at(k).front() & mask)] : missing;
+		stat[StdDev] = c > 1 ? std::sqrt(qMax(m2s.at(k), 0.0) / (c - 1)) : missing;
+		Column *const *o = outputs.constData() + k * StatisticCount;
+		for (int s = 0; s < StatisticCount; ++s) {
+			if ( ! o[s] || ! o[s]->live) continue;
+			if (row < 0) o[s]->setDouble(stat[s]);
+			else o[s]->rows[row].d = stat[s];
+		}
+	}
+}
+
+void WindowModule::evict() {
+	int slot = (int) (oldest & (capacity - 1));
+	const double *v = values.constData();
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		double x = v[k * capacity + slot];
+		if (x != x) continue;
+		if (--counts[k] == 0) {
+			means[k] = 0;
+			m2s[k] = 0;
+		}
+		else {
+			double d = x - means.at(k);
+			means[k] -= d / counts.at(k);
+			m2s[k] -= d * (x - means.at(k));
+		}
+		if (minima.at(k).count && minima.at(k).front() == oldest) minima[k].popFront();
+		if (maxima.at(k).count && maxima.at(k).front() == oldest) maxima[k].popFront();
+	}
+	++oldest;
+}
+
+void WindowModule::resync() {
+	int mask = capacity - 1;
+	const double *v = values.constData();
+	for (int k = 0, n = line.size(); k < n; ++k) {
+		const double *column = v + k * capacity;
+		double sum = 0;
+		qint64 c = 0;
+		for (qint64 s = oldest; s < next; ++s) {
+			double x = column[s & mask];
+			if (x != x) continue;
+			sum += x;
+			++c;
+		}
+		double mean = c ? sum / c : 0, m2 = 0;
+		for (qint64 s = oldest; s < next; ++s) {
+			double x = column[s & mask];
+			if (x == x) m2 += (x - mean) * (x - mean);
+		}
+		counts[k] = c;
+		means[k] = mean;
+		m2s[k] = m2;
+	}
+	sinceResync = 0;
+}
+
+void WindowModule::reset() {
+	oldest = next = 0;
+	sinceResync = 0;
+	times.resize(capacity);
+	values.resize(capacity * handles.size());
+	for (int k = 0; k < handles.size(); ++k) {
+		counts[k] = 0;
+		means[k] = 0;
+		m2s[k] = 0;
+		minima[k].clear();
+		minima[k].reserve(capacity);
+		maxima[k].clear();
+		maxima[k].reserve(capacity);
+	}
+}
+
+void WindowModule::grow() {
+	int grown = capacity * 2;
+	int oldMask = capacity - 1, newMask = grown - 1;
+	QVector<qint64> newTimes(grown);
+	QVector<double> newValues(grown * handles.size());
+	for (qint64 s = oldest; s < next; ++s) {
+		newTimes[s & newMask] = times.at(s & oldMask);
+		for (int k = 0; k < handles.size(); ++k)
+			newValues[k * grown + (s & newMask)] = values.at(k * capacity + (s & oldMask));
+	}
+	times = newTimes;
+	values = newValues;
+	capacity = grown;
+	for (int k = 0; k < handles.size(); ++k) {
+		minima[k].reserve(capacity);
+		maxima[k].reserve(capacity);
+	}
+}
+
+rapidjson::Value WindowModule::publishSettings(rapidjson::MemoryPoolAllocator<> &a) const {
+	Value s(kObjectType);
+	Value columns(kObjectType);
+	columns.AddMember("t", "array", a);
+	columns.AddMember("d", "Names of the columns to aggregate", a);
+	s.AddMember("Columns", columns, a);
+	Value window(kObjectType);
+	window.AddMember("t", "int", a);
+	window.AddMember("d", "Window length in lines", a);
+	s.AddMember("Window", window, a);
+	Value seconds(kObjectType);
+	seconds.AddMember("t", "double", a);
+	seconds.AddMember("d", "Window length in seconds, instead of lines", a);
+	s.AddMember("Seconds", seconds, a);
+	Value time(kObjectType);
+	time.AddMember("t", "string", a);
+	time.AddMember("d", "Timestamp column for time windows; the path's clock if unset", a);
+	s.AddMember("Time", time, a);
+	Value statistics(kObjectType);
+	statistics.AddMember("t", "array", a);
+	statistics.AddMember("d", "Any of Mean, Min, Max and StdDev; all if unset", a);
+	s.AddMember("Statistics", statistics, a);
+	return s;
+}
+
+rapidjson::Value WindowModule::publishActions(rapidjson::MemoryPoolAllocator<> &a) const {
+	(void) a;
+	return Value(rapidjson::kNullType);
+}
+
+void WindowModule::cleanup() {
+	
+}
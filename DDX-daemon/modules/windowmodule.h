@@ -0,0 +1,169 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef WINDOWMODULE_H
+#define WINDOWMODULE_H
+
+#include <QObject>
+#include <QVector>
+#include <limits>
+#include "module.h"
+
+class Path;
+
+/*!
+ * \brief Rolling mean, minimum, maximum and standard deviation of columns
+ * 
+ * Keeps a window of the last N lines, or of the lines in the last N seconds,
+ * and inserts a Double Column named after each configured Column and
+ * statistic, such as "Ozone_mean".  Every statistic is updated in constant
+ * amortized time per line however long the window is: minima and maxima
+ * from monotonic deques, and the mean and variance with Welford's method as
+ * values enter and leave, recomputed exactly once per window length so that
+ * rounding cannot accumulate.  All configured Columns are kept in flat
+ * arrays and updated in one pass per line.
+ * 
+ * Missing and malformed values (NaN, or text which does not parse) are left
+ * out of the statistics but still occupy their place in the window.  A
+ * statistic of an empty window, or the standard deviation of fewer than two
+ * values, is NaN.
+ * 
+ * ### Settings
+ * - Columns: array of the names of the Columns to aggregate
+ * - Window: the window length in lines
+ * - Seconds: the window length in seconds instead, measured by the Time
+ * column or, without one, by Module::getTime()
+ * - Time: name of a Timestamp Column to measure time windows by (optional)
+ * - Statistics: any of "Mean", "Min", "Max" and "StdDev"; all by default
+ * 
+ * \ingroup modules
+ */
+class WindowModule final : public Module
+{
+	Q_OBJECT  // Required
+public:
+	using Module::Module;  // Required
+	~WindowModule();  // Required
+	void init(rapidjson::Value &config) override;  // Required
+	void process() override;  // Required
+	void processBatch(int first, int count) override;
+	bool processesBatches() const override {return true;}
+	void beginRows(int first, int count);  // For fused chains
+	inline void processRow(int row);  // For fused chains
+	rapidjson::Value publishSettings(rapidjson::MemoryPoolAllocator<> &a) const override;
+	rapidjson::Value publishActions(rapidjson::MemoryPoolAllocator<> &a) const override;
+	void cleanup() override;  // Required
+	void handleReconfigure() override;  // Required
+	
+private:
+	enum Statistic {Mean, Min, Max, StdDev, StatisticCount};
+	
+	//! A ring of sequence numbers which can be popped from either end
+	struct Deque {
+		Deque() : head(0), count(0) {}
+		QVector<qint64> seqs;
+		int head;
+		int count;
+		void clear() {head = count = 0;}
+		qint64 front() const {return seqs.at(head);}
+		qint64 back() const {return seqs.at((head + count - 1) & (seqs.size() - 1));}
+		void popFront() {head = (head + 1) & (seqs.size() - 1); --count;}
+		void popBack() {--count;}
+		void pushBack(qint64 s) {seqs[(head + count++) & (seqs.size() - 1)] = s;}
+		void reserve(int capacity);
+	};
+	
+	//! Handles of the configured Columns
+	QVector<ColumnHandle> handles;
+	
+	//! Handle of the Time setting, or -1
+	ColumnHandle timeHandle;
+	
+	//! Window length in lines, or 0 for a time window
+	int windowLines;
+	
+	//! Window length in milliseconds for time windows
+	qint64 windowMsecs;
+	
+	bool wanted[StatisticCount];
+	
+	//! The configured Columns, or 0 for those not found
+	QVector<Column*> inputs;
+	
+	Column *timeColumn;
+	
+	//! Inserted Columns, StatisticCount per configured Column; 0 if not wanted
+	QVector<Column*> outputs;
+	
+	//! Ring capacity, a power of two
+	int capacity;
+	
+	//! Sequence number of the oldest line in the window
+	qint64 oldest;
+	
+	//! Sequence number the next line will get
+	qint64 next;
+	
+	//! Lines since the mean and variance were last recomputed exactly
+	qint64 sinceResync;
+	
+	//! Times of the lines in the window, indexed by sequence number & (capacity - 1)
+	QVector<qint64> times;
+	
+	//! Values in the window, capacity per configured Column
+	QVector<double> values;
+	
+	// Running state per configured Column
+	QVector<qint64> counts;
+	QVector<double> means;
+	QVector<double> m2s;
+	QVector<Deque> minima;
+	QVector<Deque> maxima;
+	
+	//! Scratch values of the current line, one per configured Column
+	QVector<double> line;
+	
+	//! The clock as of beginRows(), for lines without a time of their own
+	qint64 batchTime;
+	
+	//! Empty the window
+	void reset();
+	
+	//! Double the capacity of every ring
+	void grow();
+	
+	//! Add the values in #line at time \a t, drop what has left the window, and write row \a row (or current values if -1)
+	void update(qint64 t, int row);
+	
+	//! Remove the oldest line from the window
+	void evict();
+	
+	//! Recompute every mean and variance from the window
+	void resync();
+};
+
+void WindowModule::processRow(int row) {
+	for (int k = 0, n = inputs.size(); k < n; ++k) {
+		bool ok = false;
+		double x = inputs.at(k) ? inputs.at(k)->rowDouble(row, &ok) : 0;
+		line[k] = ok ? x : std::numeric_limits<double>::quiet_NaN();
+	}
+	update(timeColumn ? timeColumn->rowInt(row) : batchTime, row);
+}
+
+#endif // WINDOWMODULE_H
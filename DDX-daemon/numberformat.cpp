@@ -0,0 +1,189 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "numberformat.h"
+#include "../rapidjson/include/rapidjson/internal/dtoa.h"
+#include "../rapidjson/include/rapidjson/internal/itoa.h"
+#include <QDateTime>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+//! Powers of ten which are exact as doubles, for formatFixed()
+static const double powersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+};
+
+//! Writes NaN and infinities; returns 0 for finite values
+static inline int formatSpecial(double d, char *out) {
+	if (std::isnan(d)) {
+		memcpy(out, "nan", 3);
+		return 3;
+	}
+	if (std::isinf(d)) {
+		if (d < 0) {
+			memcpy(out, "-inf", 4);
+			return 4;
+		}
+		memcpy(out, "inf", 3);
+		return 3;
+	}
+	return 0;
+}
+
+//! Writes \a v as exactly \a width digits
+static inline void writeDigits(quint64 v, int width, char *out) {
+	for (int i = width - 1; i >= 0; --i) {
+		out[i] = (char) ('0' + v % 10);
+		v /= 10;
+	}
+}
+
+int NumberFormat::formatDouble(double d, char *out) {
+	int n = formatSpecial(d, out);
+	if (n) return n;
+	// Like QByteArray::number(), zero has no sign
+	if (d == 0) {
+		out[0] = '0';
+		return 1;
+	}
+	if (d < 0) {
+		out[n++] = '-';
+		d = -d;
+	}
+	char digits[32];
+	int count, k;
+	rapidjson::internal::Grisu2(d, digits, &count, &k);
+	while (count > 1 && digits[count - 1] == '0') {
+		--count;
+		++k;
+	}
+	// The value is 0.digits * 10^point
+	int point = count + k;
+	// QLocale's choice for the shortest 'g' form, which it makes by length
+	if (point > 0 && point <= count + 5) {
+		if (point >= count) {
+			memcpy(out + n, digits, count);
+			memset(out + n + count, '0', point - count);
+			return n + point;
+		}
+		memcpy(out + n, digits, point);
+		out[n + point] = '.';
+		memcpy(out + n + point + 1, digits + point, count - point);
+		return n + count + 1;
+	}
+	if (point <= 0 && point >= -3) {
+		out[n++] = '0';
+		out[n++] = '.';
+		memset(out + n, '0', -point);
+		n -= point;
+		memcpy(out + n, digits, count);
+		return n + count;
+	}
+	out[n++] = digits[0];
+	if (count > 1) {
+		out[n++] = '.';
+		memcpy(out + n, digits + 1, count - 1);
+		n += count - 1;
+	}
+	out[n++] = 'e';
+	int exponent = point - 1;
+	out[n++] = exponent < 0 ? '-' : '+';
+	exponent = exponent < 0 ? -exponent : exponent;
+	// Exponents are padded to two digits
+	int width = exponent >= 100 ? 3 : 2;
+	writeDigits((quint64) exponent, width, out + n);
+	return n + width;
+}
+
+int NumberFormat::formatFixed(double d, int decimals, char *out) {
+	int n = formatSpecial(d, out);
+	if (n) return n;
+	decimals = qBound(0, decimals, 17);
+	double scaled = std::fabs(d) * powersOfTen[decimals];
+	// Beyond 2^53 integers are no longer exact, so leave those to the C library
+	if (scaled >= 9007199254740992.0) {
+		// Past this the text would not fit
+		if (std::fabs(d) >= std::pow(10.0, 37 - decimals)) return formatDouble(d, out);
+		return snprintf(out, NUMBER_FORMAT_MAX, "%.*f", decimals, d);
+	}
+	/* The product was rounded, so add back its exact error before rounding
+	 * to the nearest integer, with halves away from zero as in QLocale */
+	double error = std::fma(std::fabs(d), powersOfTen[decimals], -scaled);
+	double whole = std::floor(scaled);
+	quint64 v = (quint64) whole + ((scaled - whole - 0.5) + error >= 0);
+	if (d < 0) out[n++] = '-';
+	quint64 unit = (quint64) powersOfTen[decimals];
+	n = (int) (rapidjson::internal::u64toa(v / unit, out + n) - out);
+	if (decimals) {
+		out[n++] = '.';
+		writeDigits(v % unit, decimals, out + n);
+		n += decimals;
+	}
+	return n;
+}
+
+int NumberFormat::formatInt(qint64 i, char *out) {
+	return (int) (rapidjson::internal::i64toa(i, out) - out);
+}
+
+int NumberFormat::formatTimestamp(qint64 msecs, char *out) {
+	qint64 days = msecs / 86400000;
+	qint64 ms = msecs % 86400000;
+	if (ms < 0) {
+		ms += 86400000;
+		--days;
+	}
+	// Civil date from days since 1970-01-01, after Howard Hinnant's days_from_civil inverse
+	qint64 z = days + 719468;
+	qint64 era = (z >= 0 ? z : z - 146096) / 146097;
+	qint64 doe = z - era * 146097;
+	qint64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	qint64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	qint64 mp = (5 * doy + 2) / 153;
+	qint64 day = doy - (153 * mp + 2) / 5 + 1;
+	qint64 month = mp < 10 ? mp + 3 : mp - 9;
+	qint64 year = yoe + era * 400 + (month <= 2);
+	if (year < 0 || year > 9999) {
+		QByteArray s = QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC)
+				.toString("yyyy-MM-dd'T'HH:mm:ss.zzz'Z'").toLatin1().left(NUMBER_FORMAT_MAX);
+		memcpy(out, s.constData(), s.size());
+		return s.size();
+	}
+	writeDigits(year, 4, out);
+	out[4] = '-';
+	writeDigits(month, 2, out + 5);
+	out[7] = '-';
+	writeDigits(day, 2, out + 8);
+	out[10] = 'T';
+	writeDigits(ms / 3600000, 2, out + 11);
+	out[13] = ':';
+	writeDigits(ms / 60000 % 60, 2, out + 14);
+	out[16] = ':';
+	writeDigits(ms / 1000 % 60, 2, out + 17);
+	out[19] = '.';
+	writeDigits(ms % 1000, 3, out + 20);
+	out[23] = 'Z';
+	return 24;
+}
+
+void NumberFormat::assign(QByteArray &buffer, const char *s, int n) {
+	buffer.resize(n);
+	memcpy(buffer.data(), s, n);
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+//! Longest text any NumberFormat function writes, in bytes
+#define NUMBER_FORMAT_MAX 40
+
+/*!
+ * \brief Allocation-free formatting of numbers and timestamps
+ * 
+ * Every function writes into a caller's buffer of at least
+ * #NUMBER_FORMAT_MAX bytes and returns the length written, without a
+ * terminating null.  Column::format() uses these, and Inlets and sinks
+ * which build text lines can write them straight into an existing buffer
+ * with Column::setText(const char*, int) or assign().
+ * 
+ * The text matches QByteArray::number() with the same arguments, with two
+ * exceptions.  Shortest doubles take their digits from the Grisu2
+ * implementation that ships with RapidJSON, which always round-trips but
+ * very rarely gives one digit more than QLocale.  Fixed doubles too large to
+ * scale exactly, from 2^53 scaled, are rounded by the C library, which breaks
+ * exact ties to even rather than away from zero.
+ */
+class NumberFormat
+{
+public:
+	
+	/*!
+	 * \brief Write the shortest text which reads back as exactly \a d
+	 * 
+	 * Like QLocale's shortest 'g' form, the value is written in scientific
+	 * notation with a signed exponent of at least two digits ("1e+20",
+	 * "1e-05") unless that is no shorter than positional notation.  Zero has
+	 * no sign, and NaN and infinities are "nan", "inf" and "-inf".
+	 */
+	static int formatDouble(double d, char *out);
+	
+	/*!
+	 * \brief Write \a d rounded to a fixed number of decimal places
+	 * \param decimals Places after the point, from 0 to 17
+	 * 
+	 * Halves round away from zero.  Values whose text would not fit in
+	 * #NUMBER_FORMAT_MAX bytes are written by formatDouble() instead.
+	 */
+	static int formatFixed(double d, int decimals, char *out);
+	
+	static int formatInt(qint64 i, char *out);
+	
+	/*!
+	 * \brief Write milliseconds since the UTC epoch as yyyy-MM-ddTHH:mm:ss.zzzZ
+	 * 
+	 * Years outside 0 to 9999 go through QDateTime, which allocates.
+	 */
+	static int formatTimestamp(qint64 msecs, char *out);
+	
+	/*!
+	 * \brief Replace the contents of \a buffer
+	 * 
+	 * Reuses the capacity of \a buffer, so this only allocates if it has
+	 * never been this long or is shared.
+	 */
+	static void assign(QByteArray &buffer, const char *s, int n);
+};
+
+#endif // NUMBERFORMAT_H
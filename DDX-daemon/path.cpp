@@ -20,9 +20,17 @@
 #include "daemon.h"
 #include "module.h"
 #include "inlet.h"
+#include "pathstage.h"
 #include "pathmanager.h"
 #include "logger.h"
+#include "fusedchain.h"
+#include "pathclock.h"
+#include "sampler.h"
+#include "scheduler.h"
 #include "rapidjson_using.h"
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
 
 Path::Path(Daemon *daemon, const QByteArray &name, const QByteArray &scheme) : QObject(0)
 {
@@ -31,17 +39,35 @@ Path::Path(Daemon *daemon, const QByteArray &name, const QByteArray &scheme) : Q
 	this->scheme = scheme;
 	d = daemon;
 	lg = Logger::get();
+	um = d->getUnitManager();
+	clock = new PathClock(daemon->getTimezone(), this);
+	inlet = 0;
 	lastInitIndex = 0;
 	processPosition = 0;
+	reconfigureFrom = -1;
+	reconfiguring = false;
+	plan.reconfigureFrom = &reconfigureFrom;
+	chunkPlan.reconfigureFrom = &reconfigureFrom;
+	batchSize = 1;
+	batchFill = 0;
+	batchLines = 0;
+	flushQueued = false;
+	autoStages = 0;
+	profiledLines = 0;
+	streamLines = 0;
+	streamNsecs = 0;
+	branched = false;
+	credits.store(PIPELINE_QUEUE_DEPTH);
+	held = false;
+	holdBatches = false;
+	inletStalled = false;
+	backlogOverflows = 0;
+	reportedBacklogOverflows = 0;
 	
-	// TODO:  Check the validity of this:
-	// Threading
-	QThread *t = new QThread(daemon);
-	moveToThread(t);
-	connect(t, &QThread::started, this, &Path::init);
-	connect(this, &Path::destroyed, t, &QThread::quit);
-	connect(t, &QThread::finished, t, &QThread::deleteLater);
-	t->start();
+	// Threading: Paths share the Daemon's Path thread; Modules after the
+	// Inlet are moved onto the Scheduler by init()
+	moveToThread(daemon->getPathThread());
+	QMetaObject::invokeMethod(this, "init", Qt::QueuedConnection);
 }
 
 Path::~Path()
@@ -51,10 +77,181 @@ Path::~Path()
 }
 
 Module* Path::findModule(QString name) const {
-	for (int i = 0; i < modules.size(); ++i)
-		if (QString::compare(modules.at(i)->getName(), name, Qt::CaseInsensitive) == 0)
-			return modules.at(i);
-	return 0;
+	return moduleNames.value(name.toCaseFolded(), 0);
+}
+
+void Path::appendModule(Module *m, const ModuleList &inputs) {
+	int i = modules.size();
+	forks.append(QList<ColumnMirror*>());
+	joins.append(0);
+	readers.append(0);
+	usage.append(Usage());
+	if (modules.isEmpty()) inlet = qobject_cast<Inlet*>(m);
+	else if (inputs.size() < 2) {
+		int up = inputs.isEmpty() ? i - 1 : modules.indexOf(inputs.first());
+		if (up < 0) {
+			alert("DDX bug: Module appended with an input which is not in the Path", m);
+			up = i - 1;
+		}
+		m->setInputColumnsPtr(branchFrom(up));
+	}
+	else {
+		Join *j = new Join;
+		for (int k = 0; k < inputs.size(); ++k) {
+			int up = modules.indexOf(inputs.at(k));
+			if (up < 0) {
+				alert("DDX bug: Module appended with an input which is not in the Path", m);
+				continue;
+			}
+			j->inputs.append(branchFrom(up));
+		}
+		j->versions.fill(0, j->inputs.size());
+		joins[i] = j;
+		branched = true;
+		m->setInputColumnsPtr(&j->columns);
+	}
+	modules.append(m);
+	moduleNames.insert(QString(m->getName()).toCaseFolded(), m);
+	plan.end = stageEnd();
+	plan.valid = false;
+	chunkPlan.valid = false;
+}
+
+const DataDef* Path::branchFrom(int i) {
+	// The first reader can modify the output in place like any linear Path
+	if (readers[i]++ == 0) return modules.at(i)->getOutputColumns();
+	branched = true;
+	ColumnMirror *mirror = new ColumnMirror(&columnPool);
+	forks[i].append(mirror);
+	return mirror->columns();
+}
+
+void Path::reconfigureModule(int i) {
+	Join *j = joins.at(i);
+	if (j) {
+		bool changed = false;
+		for (int k = 0; k < j->inputs.size(); ++k) {
+			if (j->versions.at(k) == j->inputs.at(k)->version()) continue;
+			j->versions[k] = j->inputs.at(k)->version();
+			changed = true;
+		}
+		if (changed) {
+			DataDef merged;
+			for (int k = 0; k < j->inputs.size(); ++k) {
+				const DataDef *in = j->inputs.at(k);
+				for (DataDef::const_iterator it = in->begin(); it != in->end(); ++it)
+					if ( ! merged.find((*it)->h)) merged.append(*it);
+			}
+			j->columns = merged;
+		}
+	}
+	modules.at(i)->reconfigure();
+	updateLiveness(i);
+	followForks(i);
+}
+
+void Path::updateLiveness(int i) {
+	Module *m = modules.at(i);
+	if ( ! m->inputColumns) return;  // The Inlet reads nothing
+	Usage u;
+	u.seen.reserve(m->inputColumns->size());
+	for (DataDef::const_iterator it = m->inputColumns->begin(); it != m->inputColumns->end(); ++it)
+		u.seen.append((*it)->h);
+	u.reads = m->declared ? m->reads + m->writes : u.seen;
+	u.writes = m->writes;
+	u.keep = m->filter.predicates();
+	u.transparent = m->declared && m->processesBatches() && m->isStateless();
+	for (int k = 0; k < u.keep.size(); ++k)
+		if (u.keep.at(k).kind == LinePredicate::Changed) u.transparent = false;
+	QMutexLocker l(&liveLock);
+	usage[i] = u;
+	QSet<ColumnHandle> dead;
+	for (int k = 0; k < usage.size(); ++k)
+		for (int j = 0; j < usage.at(k).seen.size(); ++j)
+			dead.insert(usage.at(k).seen.at(j));
+	for (int k = 0; k < usage.size(); ++k)
+		for (int j = 0; j < usage.at(k).reads.size(); ++j)
+			dead.remove(usage.at(k).reads.at(j));
+	/* Filters can move up to the Inlet past Modules which would not notice
+	 * the missing lines, as long as the tested Columns are still the Inlet's */
+	QVector<LinePredicate> pushed;
+	if ( ! branched) {
+		QSet<ColumnHandle> written;
+		for (int k = 1; k < usage.size(); ++k) {
+			const Usage &v = usage.at(k);
+			for (int j = 0; j < v.keep.size(); ++j)
+				if ( ! written.contains(v.keep.at(j).h)) pushed.append(v.keep.at(j));
+			if ( ! v.transparent) break;
+			for (int j = 0; j < v.writes.size(); ++j)
+				written.insert(v.writes.at(j));
+		}
+	}
+	if (dead == deadHandles && pushed == pushdown) return;
+	deadHandles = dead;
+	pushdown = pushed;
+	liveGeneration.ref();
+}
+
+void Path::invalidatePlan(Module *m) {
+	int i = modules.indexOf(m);
+	if (i < 0) return;
+	if (i < stageEnd()) plan.valid = chunkPlan.valid = false;
+	for (int k = 0; k < stages.size(); ++k)
+		if (i >= stages.at(k)->first && i < stages.at(k)->end) stages.at(k)->plan.valid = false;
+}
+
+int Path::dropRows(const PlanStep &step, int lines) {
+	QVector<const char*> marks;
+	for (int j = 0; j < step.modules.size(); ++j)
+		if (step.modules.at(j)->dropsLines()) marks.append(step.modules.at(j)->droppedRows.constData());
+	const DataDef *out = modules.at(step.end - 1)->getOutputColumns();
+	DataDef::const_iterator it, end = out->end();
+	int kept = 0;
+	for (int row = 0; row < lines; ++row) {
+		int k = 0;
+		while (k < marks.size() && ! marks.at(k)[row]) ++k;
+		if (k < marks.size()) continue;
+		if (kept != row)
+			for (it = out->begin(); it != end; ++it)
+				(*it)->moveRow(row, kept);
+		++kept;
+	}
+	return kept;
+}
+
+int Path::filterRows(Module *m, int lines) {
+	m->filter.bind(m->inputColumns);
+	DataDef::const_iterator it, end = m->inputColumns->end();
+	int kept = 0;
+	for (int row = 0; row < lines; ++row) {
+		if ( ! m->filter.passes(row)) continue;
+		if (kept != row)
+			for (it = m->inputColumns->begin(); it != end; ++it)
+				(*it)->moveRow(row, kept);
+		++kept;
+	}
+	return kept;
+}
+
+const DataDef* Path::forkSource(int i) const {
+	if (i == 0 && ! stages.isEmpty() && stages.first()->first == 1)
+		return stages.first()->mirror.columns();
+	return modules.at(i)->getOutputColumns();
+}
+
+void Path::followForks(int i) {
+	const QList<ColumnMirror*> &f = forks.at(i);
+	for (int k = 0; k < f.size(); ++k)
+		f.at(k)->follow(forkSource(i));
+}
+
+void Path::feedBranches(int i, bool batch) {
+	const QList<ColumnMirror*> &f = forks.at(i);
+	const DataDef *out = forkSource(i);
+	for (int k = 0; k < f.size(); ++k) {
+		if (batch) f.at(k)->copyRows(out);
+		else f.at(k)->copyValues(out);
+	}
 }
 
 QJsonObject Path::publishSettings() const {
@@ -66,6 +263,108 @@ QJsonObject Path::publishActions() const {
 	// TODO:  Funciton needs complete rewriting
 }
 
+QDateTime Path::getTime() const {
+	return clock->getTime();
+}
+
+QJsonObject Path::publishStats() const {
+	QJsonObject o;
+	if (inlet) {
+		o.insert("QueueHighWater", inlet->queueHighWaterMark());
+		o.insert("QueueOverflows", (double) inlet->queueOverflowCount());
+		if ( ! inlet->samplingChannels.isEmpty()) {
+			QJsonArray channels;
+			for (int i = 0; i < inlet->samplingChannels.size(); ++i)
+				channels.append(d->getSampler()->channelStats(inlet->samplingChannels.at(i)));
+			o.insert("SamplingChannels", channels);
+		}
+	}
+	if ( ! stages.isEmpty()) {
+		QJsonArray depths;
+		for (int i = 0; i < stages.size(); ++i)
+			depths.append(stages.at(i)->highWaterMark());
+		o.insert("StageQueueHighWater", depths);
+		o.insert("BacklogOverflows", (double) backlogOverflows);
+	}
+	o.insert("ReconfiguresAvoided", reconfiguresAvoided.load());
+	if (clock->isVirtual()) o.insert("ClockTime", clock->getTime().toString(Qt::ISODate));
+	if (inlet && inlet->isFinite() && streamTimer.isValid()) {
+		qint64 nsecs = streamNsecs ? streamNsecs : qMax(streamTimer.nsecsElapsed(), (qint64) 1);
+		o.insert("StreamLines", (double) streamLines);
+		o.insert("LinesPerSecond", streamLines * 1e9 / nsecs);
+	}
+	return o;
+}
+
+void Path::setStageBoundaries(QList<int> firsts) {
+	if (batchLines) {
+		alert("DDX bug: setStageBoundaries() called while a batch was running");
+		return;
+	}
+	// Stages can only be rearranged once nothing is in flight through them
+	whenDrained([this, firsts]() {applyStageBoundaries(firsts);});
+}
+
+void Path::applyStageBoundaries(QList<int> firsts) {
+	std::sort(firsts.begin(), firsts.end());
+	for (int i = firsts.size() - 1; i >= 0; --i)
+		if (firsts.at(i) < 1 || firsts.at(i) >= modules.size() || (i && firsts.at(i) == firsts.at(i - 1)))
+			firsts.removeAt(i);
+	// A branched Path can only hand everything after its Inlet to one stage
+	if (branched && ! firsts.isEmpty() && (firsts.size() > 1 || firsts.first() != 1 || joins.at(1))) {
+		alert(tr("Paths with branches can only be split after the inlet"));
+		return;
+	}
+	// Everything from the earliest old or new boundary on must be reconfigured
+	int from = modules.size();
+	if ( ! stages.isEmpty()) from = stages.first()->first;
+	if ( ! firsts.isEmpty()) from = qMin(from, firsts.first());
+	// Join the old stages back onto their upstream Modules
+	QList<PathStage*> old = stages;
+	stages.clear();
+	for (int i = 0; i < old.size(); ++i)
+		modules.at(old.at(i)->first)->setInputColumnsPtr(modules.at(old.at(i)->first - 1)->getOutputColumns());
+	for (int i = 0; i < firsts.size(); ++i) {
+		int end = i + 1 < firsts.size() ? firsts.at(i + 1) : modules.size();
+		PathStage *s = new PathStage(this, firsts.at(i), end);
+		if ( ! stages.isEmpty()) stages.last()->next = s;
+		stages.append(s);
+	}
+	plan.end = stageEnd();
+	plan.valid = false;
+	chunkPlan.valid = false;
+	// Reconfigure in order so that each mirror starts with its upstream structure
+	int stage = 0;
+	for (int i = from; i < modules.size(); ++i) {
+		if (stage < stages.size() && stages.at(stage)->first == i) {
+			PathStage *s = stages.at(stage++);
+			const DataDef *up = modules.at(i - 1)->getOutputColumns();
+			s->mirror.setSchema(ColumnMirror::describe(up));
+			s->sentVersion = up->version();
+			modules.at(i)->setInputColumnsPtr(s->mirror.columns());
+		}
+		// Later readers of the Inlet follow whichever copy of its output is used now
+		if (i == from && branched) followForks(i - 1);
+		reconfigureModule(i);
+	}
+	// Old mirrors may only go once nothing refers to their Columns
+	qDeleteAll(old);
+	log(tr("Split into %1 stages").arg(stages.size() + 1));
+}
+
+void Path::setAutoStages(int count) {
+	if (count < 2) {
+		setStageBoundaries(QList<int>() << 1);
+		return;
+	}
+	setStageBoundaries(QList<int>());
+	whenDrained([this, count]() {
+		autoStages = count;
+		profiledLines = 0;
+		moduleCost.fill(0, modules.size());
+	});
+}
+
 void Path::terminate() {
 	if (state != State::Initializing) {
 		alert("DDX bug:  Something tried to terminate outside of init()");
@@ -111,13 +410,21 @@ void Path::init() {
 	scheme.clear();
 	
 	// Instantiate and connect all constituent Modules
-	QJsonArray schemeArray = schemeDoc.array();
+	QJsonObject schemeObj = schemeDoc.object();
+	QJsonArray schemeArray = schemeObj.value("modules").toArray();
+	QList<int> stageFirsts;
 	
 	for (QJsonArray::const_iterator it = schemeArray.constBegin(); it != schemeArray.constEnd(); ++it) {
 		QJsonObject obj = it->toObject();
 		QString n = obj.value("n").toString();
 		QString t = obj.value("t").toString();
-		modules.append(um->constructModule(t, this, n));
+		ModuleList inputs;
+		QJsonArray in = obj.value("in").isArray() ? obj.value("in").toArray() : QJsonArray();
+		if (obj.value("in").isString()) in.append(obj.value("in"));
+		for (QJsonArray::const_iterator i = in.constBegin(); i != in.constEnd(); ++i)
+			inputs.append(findModule(i->toString()));
+		appendModule(um->constructModule(t, this, n), inputs);
+		if (obj.value("new_stage").toBool()) stageFirsts.append(modules.size() - 1);
 		
 		
 		
@@ -166,7 +473,20 @@ void Path::init() {
 	// TODO:  Wait for all requested Beacons to be ready before continuing??
 	
 	// Send initial reconfigure
-	reconfigure();
+	reconfigureFrom = processPosition;
+	applyReconfigure();
+	// Every line goes on in a branched Path, which a decimator or filter would not expect
+	if (branched)
+		for (int i = 1; i < modules.size(); ++i) {
+			if (modules.at(i)->dropsLines())
+				alert(tr("Paths with branches cannot drop lines, so every line will pass this Module"), modules.at(i));
+			else if ( ! modules.at(i)->filter.isEmpty())
+				alert(tr("Paths with branches ignore filters, so every line will reach this Module"), modules.at(i));
+		}
+	// Split into pipeline stages once every Module has its structure
+	/*if (schemeObj.contains("stages"))
+		setAutoStages(schemeObj.value("stages").toInt());
+	else if ( ! stageFirsts.isEmpty()) setStageBoundaries(stageFirsts);*/
 	state = State::Ready;
 	emit ready(this);
 	alert("finished init");
@@ -179,21 +499,167 @@ void Path::start() {
 	}
 	state = State::Running;
 	emit running(this);
+	clock->start();
 	inlet->start();
+	if (inlet->isFinite()) {
+		streamLines = 0;
+		streamNsecs = 0;
+		streamTimer.start();
+		QMetaObject::invokeMethod(inlet, "drainFinite", Qt::QueuedConnection);
+	}
+}
+
+int Path::chunkPrefix() const {
+	if (branched) return 1;
+	int end = 1;
+	while (end < stageEnd() && forks.at(end - 1).isEmpty()
+		   && modules.at(end)->processesBatches() && modules.at(end)->isStateless()
+		   && modules.at(end)->filter.isEmpty() && ! modules.at(end)->dropsLines()) ++end;
+	return end;
+}
+
+bool Path::readChunks() {
+	// Wait for the stages rather than read a round which cannot be sent
+	if ( ! stages.isEmpty() && (holdBatches || ! takeCredit())) {
+		held = true;
+		return true;
+	}
+	if (reconfigureFrom >= 0) applyReconfigure();
+	inlet->refreshLiveness();
+	inlet->refreshPushdown();
+	if ( ! chunkPlan.valid) {
+		chunkPlan.first = chunkPrefix();
+		chunkPlan.end = stageEnd();
+	}
+	int prefix = chunkPlan.first;
+	Scheduler *scheduler = d->getScheduler();
+	int chunks = scheduler->workerCount();
+	int lines = chunks * FINITE_CHUNK_LINES;
+	/* Each chunk writes its own rows, which is only safe if no write has to
+	 * copy storage still shared with a stage reading an earlier round */
+	DataDef::const_iterator it;
+	const DataDef *in = inlet->getOutputColumns();
+	for (it = in->begin(); it != in->end(); ++it) {
+		(*it)->resizeRows(lines);
+		(*it)->detachRows();
+	}
+	for (int i = 1; i < prefix; ++i) {
+		modules.at(i)->prepareBatch(lines);
+		const DataDef *out = modules.at(i)->getOutputColumns();
+		for (it = out->begin(); it != out->end(); ++it)
+			(*it)->detachRows();
+	}
+	/* Pushed filters which test each line on its own are applied to every
+	 * chunk before the prefix runs; Changed ones are left to their owner */
+	LineFilter *pushed = 0;
+	if ( ! inlet->pushdown.isEmpty() && ! inlet->pushdown.dependsOnOrder()) {
+		inlet->pushdown.bind(in);
+		pushed = &inlet->pushdown;
+	}
+	QVector<int> read(chunks), kept(chunks);
+	int *counts = read.data(), *keeps = kept.data();
+	qint64 base = streamLines;
+	scheduler->parallelFor(chunks, [this, prefix, base, counts, keeps, pushed, in](int k) {
+		int row = k * FINITE_CHUNK_LINES;
+		int n = inlet->readLines(base + row, row, FINITE_CHUNK_LINES);
+		counts[k] = n;
+		if (pushed && n > 0) {
+			int passed = row;
+			for (int r = row; r < row + n; ++r) {
+				if ( ! pushed->passes(r)) continue;
+				if (passed != r)
+					for (DataDef::const_iterator c = in->begin(); c != in->end(); ++c)
+						(*c)->moveRow(r, passed);
+				++passed;
+			}
+			n = passed - row;
+		}
+		keeps[k] = n;
+		// While the chunk's rows are still in cache
+		for (int i = 1; i < prefix && n > 0; ++i)
+			modules.at(i)->processBatch(row, n);
+	});
+	/* Chunks sit in stream order, so the merge only has to find the end and
+	 * close any gaps the pushed filters left */
+	const DataDef *merged = modules.at(prefix - 1)->getOutputColumns();
+	int readTotal = 0, total = 0;
+	for (int k = 0; k < chunks; ++k) {
+		int row = k * FINITE_CHUNK_LINES;
+		if (total != row)
+			for (int r = 0; r < kept.at(k); ++r)
+				for (it = merged->begin(); it != merged->end(); ++it)
+					(*it)->moveRow(row + r, total + r);
+		total += qMax(kept.at(k), 0);
+		readTotal += qMax(read.at(k), 0);
+		if (read.at(k) < FINITE_CHUNK_LINES) break;
+	}
+	streamLines += readTotal;
+	if ( ! total) {
+		if ( ! stages.isEmpty()) returnCredit();
+		return readTotal == lines;
+	}
+	// The rest of the Path takes the round as one batch, in order
+	batchLines = total;
+	int kept = runModules(chunkPlan, total, &processPosition);
+	processPosition = 1;
+	if ( ! stages.isEmpty()) {
+		if (kept) stages.first()->sendLines(modules.at(stageEnd() - 1)->getOutputColumns(), kept);
+		else returnCredit();
+	}
+	batchLines = 0;
+	return readTotal == lines;
+}
+
+void Path::finish() {
+	whenDrained([this]() {
+		// Every stage is idle, so this thread can run the last lines through all of them
+		for (int i = 1; i < modules.size(); ++i) {
+			processPosition = i + 1;
+			while (modules.at(i)->finishStream()) {
+				if (reconfigureFrom >= 0) applyReconfigure();
+				if (branched) feedBranches(i, false);
+				processFrom(i + 1);
+				processPosition = i + 1;
+			}
+		}
+		processPosition = 1;
+		streamNsecs = qMax(streamTimer.nsecsElapsed(), (qint64) 1);
+		log(tr("Finished %1 lines in %2 s (%3 lines/s)")
+			.arg(streamLines).arg(streamNsecs / 1e9).arg(streamLines * 1e9 / streamNsecs, 0, 'f', 0));
+		state = State::Finished;
+		emit finished(this);
+	});
 }
 
 void Path::stop() {
 	inlet->stop();
+	clock->pause();
+	// A finite Inlet's next drainFinite() sees this and stops
 	state = State::Ready;
-	emit stopped(this);
+	inletStalled = false;
+	whenDrained([this]() {emit stopped(this);});
 }
 
 void Path::cleanup() {
+	whenDrained([this]() {cleanupDrained();});
+}
+
+void Path::cleanupDrained() {
 	// TODO
+	batchFill = 0;
+	qDeleteAll(stages);
+	stages.clear();
+	for (int i = 0; i < forks.size(); ++i)
+		qDeleteAll(forks.at(i));
+	forks.clear();
+	qDeleteAll(joins);
+	joins.clear();
 	for (int i = 0; i < lastInitIndex; ++i)
 		modules.at(i)->cleanup();
 	for (int i = 0; i < modules.size(); ++i)
 		delete modules.at(i);
+	modules.clear();
+	inlet = 0;
 	// TODO: remove
 	//emit readyForDeletion();
 	deleteLater();
@@ -206,8 +672,190 @@ void Path::reconfigure() {
 		return;
 	}
 #endif
-	for (int i = processPosition; i < modules.size(); ++i)
-		modules.at(i)->reconfigure();
+	PathStage *s = PathStage::current();
+	int position = s ? s->position : processPosition;
+	int &from = s ? s->reconfigureFrom : reconfigureFrom;
+	if ((s ? s->reconfiguring : reconfiguring) || from >= 0) {
+		reconfiguresAvoided.ref();
+		if (from < 0) return;  // Already covered by the running reconfigure
+	}
+	if (from < 0 || position < from) from = position;
+}
+
+void Path::applyReconfigure() {
+	PathStage *s = PathStage::current();
+	if (s) {
+		if (s->reconfigureFrom < 0) return;
+		int position = s->position;
+		s->position = s->reconfigureFrom;
+		s->reconfigureFrom = -1;
+		s->reconfiguring = true;
+		reconfigureStage(s);
+		s->reconfiguring = false;
+		s->position = position;
+		return;
+	}
+	if (reconfigureFrom < 0) return;
+	int from = reconfigureFrom;
+	reconfigureFrom = -1;
+	reconfiguring = true;
+	int end = stageEnd();
+	// The Module asking may have mirrors of its own to bring up to date
+	if (branched && from > 0 && stages.isEmpty()) followForks(from - 1);
+	for (int i = from; i < end; ++i) {
+		reconfigureModule(i);
+		// New Columns need row storage if this happened in the middle of a batch
+		if (batchLines) modules.at(i)->prepareBatch(batchLines);
+	}
+	if ( ! stages.isEmpty())
+		stages.first()->sendSchema(modules.at(end - 1)->getOutputColumns());
+	reconfiguring = false;
+}
+
+void Path::runStateless(int first, int end, int lines) {
+	Scheduler *scheduler = d->getScheduler();
+	int ranges = qMin(scheduler->workerCount(), lines / SHARD_MIN_LINES);
+	if (ranges < 2) {
+		for (int i = first; i < end; ++i)
+			modules.at(i)->processBatch(0, lines);
+		return;
+	}
+	/* Writing rows from several threads is only safe if no write has to copy
+	 * storage still shared with another stage or an earlier batch */
+	DataDef::const_iterator it;
+	const DataDef *in = modules.at(first)->inputColumns;
+	for (it = in->begin(); it != in->end(); ++it)
+		(*it)->detachRows();
+	for (int i = first; i < end; ++i) {
+		const DataDef *out = modules.at(i)->getOutputColumns();
+		for (it = out->begin(); it != out->end(); ++it)
+			(*it)->detachRows();
+	}
+	int step = (lines + ranges - 1) / ranges;
+	scheduler->parallelFor((lines + step - 1) / step, [this, first, end, lines, step](int k) {
+		int row = k * step;
+		for (int i = first; i < end; ++i)
+			modules.at(i)->processBatch(row, qMin(step, lines - row));
+	});
+}
+
+void Path::reconfigureStage(PathStage *s) {
+	// The Module asking, or the stage's input, may have mirrors to bring up to date
+	if (branched) followForks(s->position - 1);
+	for (int i = s->position; i < s->end; ++i) {
+		reconfigureModule(i);
+		if (s->lines) modules.at(i)->prepareBatch(s->lines);
+	}
+	if (s->next)
+		s->next->sendSchema(modules.at(s->end - 1)->getOutputColumns());
+}
+
+int Path::stageEnd() const {
+	return stages.isEmpty() ? modules.size() : stages.first()->first;
+}
+
+bool Path::takeCredit() {
+	// Only this thread takes credits, so one seen here cannot be taken away
+	if (credits.loadAcquire() > 0) {
+		credits.deref();
+		return true;
+	}
+	creditWanted.fetchAndStoreOrdered(1);
+	// A credit returned before the flag was seen is not missed
+	if (credits.fetchAndAddOrdered(0) > 0) {
+		credits.deref();
+		return true;
+	}
+	return false;
+}
+
+void Path::returnCredit() {
+	credits.fetchAndAddOrdered(1);
+	if (creditWanted.testAndSetOrdered(1, 0))
+		QMetaObject::invokeMethod(this, "resumeSending", Qt::QueuedConnection);
+}
+
+void Path::whenDrained(const std::function<void()> &then) {
+	drainedThen.append(then);
+	// Otherwise a drain is already under way and will run it
+	if ( ! holdBatches) drainStages();
+}
+
+void Path::drainStages() {
+	held = false;
+	flushBatch();
+	if (held) return;  // resumeSending() comes back once a credit is returned
+	if (stages.isEmpty()) {
+		stagesDrained();
+		return;
+	}
+	holdBatches = true;
+	passDrainMarker(0);
+}
+
+void Path::passDrainMarker(int k) {
+	if (k == stages.size()) {
+		QMetaObject::invokeMethod(this, "stagesDrained", Qt::QueuedConnection);
+		return;
+	}
+	// Runs after everything queued on stage k, which has by then queued its output on the next
+	stages.at(k)->strand.post([this, k]() {passDrainMarker(k + 1);});
+}
+
+void Path::stagesDrained() {
+	holdBatches = false;
+	QList<std::function<void()> > then;
+	then.swap(drainedThen);
+	for (int i = 0; i < then.size(); ++i)
+		then.at(i)();
+	resumeSending();
+}
+
+void Path::resumeSending() {
+	if (holdBatches) return;
+	if (backlogOverflows != reportedBacklogOverflows) {
+		alert(tr("Pipeline backlog overflowed; %1 lines dropped").arg(backlogOverflows - reportedBacklogOverflows));
+		reportedBacklogOverflows = backlogOverflows;
+	}
+	held = false;
+	if ( ! drainedThen.isEmpty()) drainStages();
+	else flushBatch();
+	if (held || holdBatches) return;
+	if (inletStalled && state == State::Running) QMetaObject::invokeMethod(inlet, "drainFinite", Qt::QueuedConnection);
+	inletStalled = false;
+}
+
+QList<int> Path::balanceStages(const QVector<qint64> &cost, int count) {
+	int n = cost.size();
+	count = qMin(count, n);
+	QList<int> firsts;
+	if (count < 2) return firsts;
+	QVector<qint64> sum(n + 1, 0);
+	for (int i = 0; i < n; ++i)
+		sum[i + 1] = sum.at(i) + cost.at(i);
+	/* best[k][i] is the cheapest most expensive stage when the first i Modules
+	 * are split into k + 1 count, and cut[k][i] is where the last one starts */
+	QVector<QVector<qint64> > best(count, QVector<qint64>(n + 1, 0));
+	QVector<QVector<int> > cut(count, QVector<int>(n + 1, 0));
+	for (int i = 1; i <= n; ++i)
+		best[0][i] = sum.at(i);
+	for (int k = 1; k < count; ++k) {
+		for (int i = k + 1; i <= n; ++i) {
+			best[k][i] = -1;
+			for (int j = k; j < i; ++j) {
+				qint64 worst = qMax(best.at(k - 1).at(j), sum.at(i) - sum.at(j));
+				if (best.at(k).at(i) < 0 || worst < best.at(k).at(i)) {
+					best[k][i] = worst;
+					cut[k][i] = j;
+				}
+			}
+		}
+	}
+	for (int k = count - 1, i = n; k > 0; --k) {
+		i = cut.at(k).at(i);
+		firsts.prepend(i);
+	}
+	return firsts;
 }
 
 void Path::process() {
@@ -217,13 +865,259 @@ void Path::process() {
 		return;
 	}
 #endif
-	ModuleList::const_iterator it = modules.constBegin();
-	processPosition = 1;
-	for (++it; it < modules.constEnd(); ++it) {  // Start after the inlet
+	// This is the Inlet's line boundary
+	if (reconfigureFrom >= 0) applyReconfigure();
+	inlet->refreshLiveness();
+	inlet->refreshPushdown();
+	if (batchSize > 1 || autoStages || ! stages.isEmpty()) {
+		const DataDef *inletColumns = inlet->getOutputColumns();
+		DataDef::const_iterator it, end = inletColumns->end();
+		if (batchFill == 0) {
+			for (it = inletColumns->begin(); it != end; ++it)
+				(*it)->resizeRows(batchSize);
+			if ( ! flushQueued && batchSize > 1) {
+				flushQueued = true;
+				QMetaObject::invokeMethod(this, "queuedFlush", Qt::QueuedConnection);
+			}
+		}
+		else if (batchFill >= batchSize) {
+			// The batch is held (see flushBatch()), so it grows until the stages catch up
+			if (batchFill >= qMax(batchSize, PIPELINE_BACKLOG_LINES)) {
+				backlogOverflows++;
+				return;
+			}
+			for (it = inletColumns->begin(); it != end; ++it)
+				(*it)->resizeRows(batchFill + 1);
+		}
+		for (it = inletColumns->begin(); it != end; ++it)
+			(*it)->store(batchFill);
+		if (++batchFill >= batchSize) flushBatch();
+		return;
+	}
+	if (branched) feedBranches(0, false);
+	processFrom(1);  // Start after the inlet
+}
+
+void Path::processFrom(int first) {
+	processPosition = first;
+	for (int i = first; i < modules.size(); ++i) {
 		processPosition++;
-		(*it)->process();
+		Module *m = modules.at(i);
+		if ( ! branched && ! m->filter.isEmpty()) {
+			m->filter.bind(m->inputColumns);
+			if ( ! m->filter.passes()) break;
+		}
+		m->refreshLiveness();
+		m->process();
+		if (reconfigureFrom >= 0) applyReconfigure();
+		if (m->lineDropped) {
+			m->lineDropped = false;
+			if ( ! branched) break;
+		}
+		if (branched) feedBranches(i, false);
+	}
+	processPosition = 1;
+}
+
+void Path::flushBatch() {
+	if ( ! batchFill || batchLines) return;
+	// Nothing is run until the batch can be sent on; resumeSending() retries
+	if ( ! stages.isEmpty() && (holdBatches || ! takeCredit())) {
+		held = true;
+		return;
 	}
+	batchLines = batchFill;
+	batchFill = 0;
+	int end = stageEnd();
+	if (branched && stages.isEmpty()) feedBranches(0, true);
+	int kept = runModules(plan, batchLines, &processPosition, autoStages ? &moduleCost : 0);
 	processPosition = 1;
+	if ( ! stages.isEmpty()) {
+		// The last stage returns the credit
+		if (kept) stages.first()->sendLines(modules.at(end - 1)->getOutputColumns(), kept);
+		else returnCredit();
+	}
+	if (autoStages) profiledLines += batchLines;
+	batchLines = 0;
+	if (autoStages && profiledLines >= PIPELINE_PROFILE_LINES) {
+		// The Inlet keeps the Path thread to itself; the rest is balanced
+		QList<int> firsts = balanceStages(moduleCost.mid(1), autoStages);
+		for (int k = 0; k < firsts.size(); ++k)
+			firsts[k] += 1;
+		firsts.prepend(1);
+		autoStages = 0;
+		setStageBoundaries(firsts);
+	}
+}
+
+int Path::runModules(Plan &plan, int lines, int *position, QVector<qint64> *cost) {
+	if ( ! plan.valid) compilePlan(plan);
+	PlanStep *steps = plan.steps.data();
+	for (int i = 0, n = plan.steps.size(); i < n && lines; ++i) {
+		PlanStep &step = steps[i];
+		// Line steps apply their filters as they go
+		if (step.filtered && step.run != &Path::runLineStep) lines = filterRows(step.modules.first(), lines);
+		for (int j = 0, m = step.modules.size(); j < m; ++j)
+			step.modules.at(j)->prepareBatch(lines);
+		(this->*step.run)(step, lines, position, cost);
+		if (step.drops) lines = dropRows(step, lines);
+		if (*plan.reconfigureFrom >= 0) applyReconfigure();
+		if (step.feeds) feedBranches(step.end - 1, true);
+	}
+	return lines;
+}
+
+void Path::compilePlan(Plan &plan) {
+	plan.steps.resize(0);
+	int i = plan.first;
+	while (i < plan.end) {
+		PlanStep step;
+		step.first = i;
+		step.reconfigureFrom = plan.reconfigureFrom;
+		step.filtered = false;
+		step.drops = false;
+		step.in = 0;
+		step.out = 0;
+		step.inVersion = 0;
+		step.outVersion = 0;
+		Module *m = modules.at(i);
+		int end = i + 1;
+		int fused = 0;
+		if (m->processesBatches()) {
+			// Offer the directly linked run of batch Modules for fusion
+			int runEnd = i + 1;
+			while (runEnd < plan.end && forks.at(runEnd - 1).isEmpty() && ! modules.at(runEnd - 1)->dropsLines()
+				   && modules.at(runEnd)->processesBatches() && modules.at(runEnd)->filter.isEmpty()
+				   && modules.at(runEnd)->inputColumns == modules.at(runEnd - 1)->getOutputColumns()) ++runEnd;
+			if (runEnd - i > 1) step.fused = QSharedPointer<FusedChain>(um->fuseModules(modules.mid(i, runEnd - i), &fused));
+			// Stateless Modules alone gain more from being sharded (see runStateless())
+			bool sharded = true;
+			for (int j = i; step.fused && j < i + fused; ++j)
+				if ( ! modules.at(j)->isStateless()) sharded = false;
+			if (step.fused && sharded) step.fused.clear();
+		}
+		if (step.fused) {
+			step.run = &Path::runFusedStep;
+			end = i + fused;
+		}
+		else if (m->processesBatches() && m->isStateless()) {
+			step.run = &Path::runStatelessStep;
+			while (end < plan.end && forks.at(end - 1).isEmpty()
+				   && modules.at(end)->processesBatches() && modules.at(end)->filter.isEmpty()
+				   && modules.at(end)->isStateless()) ++end;
+		}
+		else if (m->processesBatches()) step.run = &Path::runBatchStep;
+		else {
+			/* A run of line-by-line Modules, each reading the last one's output
+			 * directly, shares one load and store per line */
+			step.run = &Path::runLineStep;
+			while (end < plan.end && forks.at(end - 1).isEmpty()
+				   && ! modules.at(end)->processesBatches()
+				   && modules.at(end)->inputColumns == modules.at(end - 1)->getOutputColumns()) ++end;
+			step.in = m->inputColumns;
+			step.out = modules.at(end - 1)->getOutputColumns();
+		}
+		step.end = end;
+		for (int j = i; j < end; ++j) {
+			step.modules.append(modules.at(j));
+			// Filters would leave the branches of a Path with different lines
+			if ( ! branched && ! modules.at(j)->filter.isEmpty()) step.filtered = true;
+			// Line steps drop as they go
+			if ( ! branched && modules.at(j)->dropsLines() && step.run != &Path::runLineStep) step.drops = true;
+		}
+		step.feeds = ! forks.at(end - 1).isEmpty();
+		plan.steps.append(step);
+		i = end;
+	}
+	plan.valid = true;
+}
+
+void Path::runFusedStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost) {
+	QElapsedTimer timer;
+	*position = step.end;
+	if (cost) timer.start();
+	step.fused->processBatch(0, lines);
+	if (cost) {
+		qint64 each = timer.nsecsElapsed() / (step.end - step.first);
+		for (int j = step.first; j < step.end; ++j)
+			(*cost)[j] += each;
+	}
+}
+
+void Path::runBatchStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost) {
+	QElapsedTimer timer;
+	*position = step.end;
+	if (cost) timer.start();
+	step.modules.at(0)->processBatch(0, lines);
+	if (cost) (*cost)[step.first] += timer.nsecsElapsed();
+}
+
+void Path::runStatelessStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost) {
+	QElapsedTimer timer;
+	*position = step.end;
+	if (cost) timer.start();
+	runStateless(step.first, step.end, lines);
+	if (cost) {
+		// Parts of the run cannot be timed separately, so share it out
+		qint64 each = timer.nsecsElapsed() / (step.end - step.first);
+		for (int j = step.first; j < step.end; ++j)
+			(*cost)[j] += each;
+	}
+}
+
+void Path::runLineStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost) {
+	QElapsedTimer timer;
+	DataDef::const_iterator it;
+	if (step.in->version() != step.inVersion) {
+		step.inVersion = step.in->version();
+		step.loads.resize(0);
+		for (it = step.in->begin(); it != step.in->end(); ++it)
+			step.loads.append(*it);
+	}
+	Module *const *ms = step.modules.constData();
+	int count = step.modules.size();
+	int kept = 0;
+	for (int row = 0; row < lines; ++row) {
+		Column *const *c = step.loads.constData();
+		for (int k = 0, n = step.loads.size(); k < n; ++k)
+			c[k]->load(row);
+		int j = 0;
+		for (; j < count; ++j) {
+			if (step.filtered && ! ms[j]->filter.isEmpty()) {
+				ms[j]->filter.bind(ms[j]->inputColumns);
+				if ( ! ms[j]->filter.passes()) break;
+			}
+			*position = step.first + j + 1;
+			if (cost) timer.start();
+			ms[j]->process();
+			if (cost) (*cost)[step.first + j] += timer.nsecsElapsed();
+			if (*step.reconfigureFrom >= 0) applyReconfigure();
+			if (ms[j]->lineDropped) {
+				ms[j]->lineDropped = false;
+				if ( ! branched) break;
+			}
+		}
+		if (j < count) continue;  // Dropped
+		// A Module in the step may have reconfigured the rest of it
+		if (step.out->version() != step.outVersion) {
+			step.outVersion = step.out->version();
+			step.stores.resize(0);
+			for (it = step.out->begin(); it != step.out->end(); ++it)
+				step.stores.append(*it);
+		}
+		/* Kept lines move to the front of the batch; a row is always loaded
+		 * before anything is stored over it */
+		c = step.stores.constData();
+		for (int k = 0, n = step.stores.size(); k < n; ++k)
+			c[k]->store(kept);
+		++kept;
+	}
+	lines = kept;
+}
+
+void Path::queuedFlush() {
+	flushQueued = false;
+	flushBatch();
 }
 
 void Path::alert(const QString msg, const Module *m) const {
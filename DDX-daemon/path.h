@@ -22,20 +22,47 @@
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <functional>
 #include "data.h"
 
 class Module;
 class Inlet;
+class PathStage;
 class Daemon;
 class PathManager;
 class Logger;
+class FusedChain;
+class PathClock;
 
 /*!
  * \brief A complete string of consecutive Modules which handles data lines
  * 
+ * ## Branches
+ * A Module normally reads the output of the Module before it, but it may
+ * instead name any earlier Module, or several of them.  Paths can therefore
+ * be directed acyclic graphs: one Inlet can feed both a storage sink and a
+ * live display, with the shared upstream Modules run once per line.  The
+ * first Module reading an output reads it directly; later ones read a
+ * ColumnMirror of it, so each branch has its own Columns and schema.  A
+ * Module with several upstream Modules reads every Column of the first,
+ * followed by the Columns of later ones whose names are not already present.
+ * Modules are always run in the order they were appended, which must put
+ * every Module after all of its upstream Modules.
+ * Schemes will name them with a Module's "in" setting, which
+ * PathManager::verifyPathScheme() already checks, once init() parses schemes
+ * again; until then branches are built by passing the upstream Modules to
+ * appendModule().
+ * 
  * ## Testing %Path Configurations
  * Paths can be built by an external configuration wizard in "test mode".  In
  * test mode, alerts are redirected to a text stream, then Module::init() is
@@ -45,17 +72,38 @@ class Logger;
  * many errors as possible.
  * 
  * ## Threading Information
- * Every Path runs in its own thread.  Modules written to communicate across
- * Paths must take this into account.  Beacons will also be run in their own
+ * Paths live on the Daemon's Path thread, which they share, and unless split
+ * into pipeline stages, the Inlet and every Module are run there, line by
+ * line or in batches.  Stages after the first run on the Daemon's Scheduler,
+ * so that hundreds of split Paths need only as many threads as there are
+ * cores.  Modules written to communicate across Paths must take this into
+ * account.  Beacons will also be run in their own
  * threads.  Any Module can start its own thread, but all functions called by a
  * Path assume synchronicity.
  * 
+ * ## Pipelining
+ * A Path can be split into further stages which run concurrently on the
+ * Scheduler, so that one expensive Module does not limit the throughput of
+ * every other one.  Splitting is opt-in, since every batch then costs a
+ * hand-off between threads.  Schemes will ask for it with a "stages" setting
+ * or a Module's "new_stage" flag, which PathManager::verifyPathScheme()
+ * already checks, once init() parses schemes again; until then call
+ * setStageBoundaries() or setAutoStages().  See also PathStage.  While a Path is split, lines are always run in batches.
+ * 
+ * ## Clock
+ * Every Path has its own PathClock, which Modules read with
+ * Module::getTime() and Inlets pace themselves with through ClockTimer.  It
+ * follows the wall clock unless set to replay from a given time, at a
+ * multiple of real time or as fast as the Path can go.
+ * 
  * \ingroup daemon
  */
 class Path : public QObject
 {
 	friend class Module;
 	friend class Inlet;
+	friend class PathStage;
+	friend class PathBench;  // Assembles Paths from code in DDX-benchmarks
 	Q_OBJECT
 public:
 	
@@ -73,7 +121,7 @@ public:
 	~Path();
 	
 	/*!
-	 * \brief Retreive a Module pointer by name via slow linear search
+	 * \brief Retreive a Module pointer by name
 	 * \param name The name of the Module
 	 * \return Pointer to a Module, or 0 if none found 
 	 * 
@@ -85,13 +133,66 @@ public:
 	
 	QJsonObject publishActions() const;
 	
+	/*!
+	 * \brief Report runtime statistics
+	 * \return A JSON object of counters
+	 * 
+	 * Includes the deepest and total dropped counts of the Inlet's queues
+	 * (see Inlet::attachQueue()) and the deepest each pipeline stage's queue
+	 * has been, and the jitter of any channels the Inlet samples (see
+	 * Inlet::addSamplingChannel()).  Paths with a finite Inlet also report
+	 * the lines read and the lines per second achieved so far, or over the
+	 * whole stream once it has finished.
+	 */
+	QJsonObject publishStats() const;
+	
+	/*!
+	 * \brief Split the Path into pipeline stages
+	 * \param firsts Indices of the Modules which begin a new stage
+	 * 
+	 * The Inlet and the Modules before the first boundary run on the Path
+	 * thread; every other stage gets its own PathStage.  Invalid and duplicate
+	 * indices are ignored, and an empty list runs the whole Path on the Path
+	 * thread.  Paths with branches can only be split after the Inlet.  The
+	 * split takes effect, and Modules after the first old or new boundary are
+	 * reconfigured, once every batch in flight has cleared the old stages (see
+	 * whenDrained()), which is before this returns if the Path is not split
+	 * yet.  Must be called from the Path's thread after the initial
+	 * reconfigure and outside of any process call.  Scheme parsing in init()
+	 * is still commented out, so this and setAutoStages() are for now the only
+	 * way to split a Path.
+	 */
+	void setStageBoundaries(QList<int> firsts);
+	
+	/*!
+	 * \brief Choose stage boundaries from measured Module cost
+	 * \param count The number of stages to split the Modules after the Inlet into
+	 * 
+	 * The Path is first joined back into one stage, then every Module is timed
+	 * over the next #PIPELINE_PROFILE_LINES lines.  Boundaries are then placed
+	 * so that the most expensive stage is as cheap as possible.  The Inlet is
+	 * always left on the Path thread by itself.  Same calling
+	 * requirements as setStageBoundaries().
+	 */
+	void setAutoStages(int count);
+	
 	/*!
 	 * Reconfigure downstream Modules
 	 * 
 	 * This function must _only_ be called by a Module's Module::process()
 	 * function and while the Path is running.  All Modules after the Module
 	 * currently in a process call will have Module::reconfigure() called in
-	 * order.  The currently active Module will be skipped.
+	 * order.  Modules in later stages are reconfigured by their own stage once
+	 * the lines before the change have passed through them.  The currently
+	 * active Module will be skipped.  Modules whose input schema version did
+	 * not change, or which declared that the change does not concern them, do
+	 * not have Module::handleReconfigure() called.
+	 * 
+	 * Requests are coalesced: downstream Modules are only reconfigured once
+	 * the asking Module returns, or for an Inlet, when it next calls
+	 * Inlet::process().  Any number of column changes and calls to this in
+	 * between cost one downstream reconfigure, and the calls saved are counted
+	 * in publishStats().
 	 */
 	void reconfigure();
 	
@@ -130,6 +231,12 @@ public:
 	 */
 	QByteArray getName() const {return name;}
 	
+	//! The clock the Path's Modules observe; see PathClock::setSpeed()
+	PathClock* getClock() const {return clock;}
+	
+	//! The current time on the Path's clock, in DDX standard form
+	QDateTime getTime() const;
+	
 signals:
 	
 	//! Emitted when \a path is ready to start
@@ -164,9 +271,28 @@ public slots:
 	
 protected:
 	
+private slots:
+	
+	//! Runs any partially filled batch once control returns to the event loop
+	void queuedFlush();
+	
+	/*!
+	 * \brief Retry whatever waited for the stages
+	 * 
+	 * Posted when the last stage returns a credit the Path thread was
+	 * waiting for, and called once the stages have drained.  Sends the held
+	 * batch, carries on with whenDrained(), and restarts a finite Inlet which
+	 * stopped to let the stages catch up.
+	 */
+	void resumeSending();
+	
+	//! Runs the whenDrained() callbacks once the drain marker has passed every stage
+	void stagesDrained();
+	
 private:
 	Daemon *d;  //!< Convenience pointer to Daemon instance
 	Logger *lg;  //!< Convenience pointer to Logger instance
+	const PathManager *um;  //!< Convenience pointer to PathManager instance
 	
 	//! This Path's name (not editable after construction)
 	QByteArray name;
@@ -177,6 +303,38 @@ private:
 	//! The ordered Module list
 	ModuleList modules;
 	
+	//! Modules keyed by case-folded name for findModule()
+	QHash<QString, Module*> moduleNames;
+	
+	//! Recycles Columns inserted by this Path's Modules
+	ColumnPool columnPool;
+	
+	//! Guards the liveness members below, which every stage updates
+	QMutex liveLock;
+	
+	//! What one Module used as of its last reconfigure
+	struct Usage {
+		Usage() : transparent(false) {}
+		QVector<ColumnHandle> reads;  //!< Handles it may read
+		QVector<ColumnHandle> seen;  //!< Handles in its input
+		QVector<ColumnHandle> writes;  //!< Declared upstream handles it writes
+		QVector<LinePredicate> keep;  //!< Its filter; see Module::declareFilter()
+		//! Whether dropping lines before it changes nothing but its line count
+		bool transparent;
+	};
+	
+	//! Usage of each Module, by index
+	QVector<Usage> usage;
+	
+	//! Handles seen by some Module but read by none
+	QSet<ColumnHandle> deadHandles;
+	
+	//! Predicates the Inlet may apply to its lines; see Inlet::passesPushdown()
+	QVector<LinePredicate> pushdown;
+	
+	//! Incremented whenever #deadHandles or #pushdown changes
+	QAtomicInt liveGeneration;
+	
 	//! Convenience pointer to Inlet
 	Inlet *inlet;
 	
@@ -192,15 +350,360 @@ private:
 	 */
 	int processPosition;
 	
+	//! First Module awaiting a coalesced reconfigure on the Path thread, or -1
+	int reconfigureFrom;
+	
+	//! Whether applyReconfigure() is running on the Path thread
+	bool reconfiguring;
+	
+	//! Calls to reconfigure() absorbed by an earlier or running one
+	QAtomicInt reconfiguresAvoided;
+	
+	//! Maximum number of lines per batch (set by Inlet::setBatchSize())
+	int batchSize;
+	
+	//! Number of lines waiting in the current batch
+	int batchFill;
+	
+	//! Number of lines in the batch being run, or 0 if none is running
+	int batchLines;
+	
+	//! Whether queuedFlush() is already scheduled
+	bool flushQueued;
+	
+	/*!
+	 * \brief The input of a Module with several upstream Modules
+	 * 
+	 * Rebuilt whenever one of the inputs changes version.
+	 */
+	struct Join {
+		QList<const DataDef*> inputs;
+		QVector<quint64> versions;  //!< Input versions #columns was built from
+		DataDef columns;
+	};
+	
+	//! Mirrors fed by each Module, one per reader after the first
+	QVector<QList<ColumnMirror*> > forks;
+	
+	//! The Join read by each Module, or 0
+	QVector<Join*> joins;
+	
+	//! Number of Modules reading each Module's output
+	QVector<int> readers;
+	
+	//! Whether any Module has several readers or several upstream Modules
+	bool branched;
+	
+	/*!
+	 * \brief One step of a Plan
+	 */
+	struct PlanStep {
+		//! Runs the step; chosen when the Plan is compiled
+		void (Path::*run)(PlanStep &step, int &lines, int *position, QVector<qint64> *cost);
+		int first;  //!< Index of the first Module
+		int end;  //!< Index one past the last Module
+		QVector<Module*> modules;  //!< The Modules from #first to #end
+		QSharedPointer<FusedChain> fused;  //!< Fused steps only: runs #modules
+		const int *reconfigureFrom;  //!< Copy of Plan#reconfigureFrom
+		bool filtered;  //!< Whether any of #modules has a filter to apply
+		bool feeds;  //!< Whether the last Module's mirrors are fed afterward
+		bool drops;  //!< Whether rows dropped by #modules are removed afterward
+		const DataDef *in;  //!< Line steps only: the Columns loaded per line
+		const DataDef *out;  //!< Line steps only: the Columns stored per line
+		quint64 inVersion;  //!< Version of #in that #loads was taken from
+		quint64 outVersion;  //!< Version of #out that #stores was taken from
+		QVector<Column*> loads;
+		QVector<Column*> stores;
+	};
+	
+	/*!
+	 * \brief A range of Modules compiled into a flat list of steps
+	 * 
+	 * Which Modules share a step, and how each step is run, only depends on
+	 * the order and linkage of the Modules, so a Plan is compiled once and
+	 * kept until the Path's structure or stages change.  Line steps keep flat
+	 * arrays of the Columns they load and store, refreshed only when a
+	 * reconfigure gives those DataDefs a new version.
+	 */
+	struct Plan {
+		Plan() : first(1), end(1), valid(false), reconfigureFrom(0) {}
+		int first;  //!< Index of the first Module
+		int end;  //!< Index one past the last Module
+		bool valid;  //!< Whether #steps is up to date
+		const int *reconfigureFrom;  //!< The owner's pending reconfigure, checked between Modules
+		QVector<PlanStep> steps;
+	};
+	
+	//! Owned as a QObject child
+	PathClock *clock;
+	
+	//! The Modules run on the Path thread, after the Inlet
+	Plan plan;
+	
+	//! The Modules run on the Path thread after those readChunks() runs per chunk
+	Plan chunkPlan;
+	
+	//! Stages after the first, in order (see setStageBoundaries())
+	QList<PathStage*> stages;
+	
+	//! Batches which may still be sent to the first stage; see takeCredit()
+	QAtomicInt credits;
+	
+	//! Set while the Path thread waits for a credit, so that returnCredit() wakes it
+	QAtomicInt creditWanted;
+	
+	//! Whether a batch is held on the Path thread because it could not be sent
+	bool held;
+	
+	//! Whether batches are held while the stages drain; see whenDrained()
+	bool holdBatches;
+	
+	//! Whether a finite Inlet stopped reading until the held batch is sent
+	bool inletStalled;
+	
+	//! Lines dropped because the held batch reached #PIPELINE_BACKLOG_LINES
+	quint64 backlogOverflows;
+	
+	//! #backlogOverflows as of the last alert
+	quint64 reportedBacklogOverflows;
+	
+	//! Callbacks waiting for the stages to drain, in order
+	QList<std::function<void()> > drainedThen;
+	
+	//! Number of stages to split into once profiled, or 0 if not profiling
+	int autoStages;
+	
+	//! Lines timed so far while profiling
+	int profiledLines;
+	
+	//! Lines read from a finite Inlet since start(); see Inlet::readLine()
+	qint64 streamLines;
+	
+	//! Times a finite Inlet's stream from start()
+	QElapsedTimer streamTimer;
+	
+	//! Nanoseconds the finite stream took once finished, or 0
+	qint64 streamNsecs;
+	
+	/*!
+	 * \brief Read one round of chunks from a finite Inlet
+	 * \return False once the stream has ended
+	 * 
+	 * One chunk per Scheduler worker, each #FINITE_CHUNK_LINES consecutive
+	 * lines, is read with Inlet::readLines() into its own rows of the batch
+	 * and run through the stateless Modules directly after the Inlet (see
+	 * chunkPrefix() and Scheduler::parallelFor()).  Lines failing the
+	 * pushdown are dropped from each chunk first unless it has Changed
+	 * predicates.  The chunks sit in stream order, so the rest of the Path
+	 * then runs the round as one ordered batch.
+	 */
+	bool readChunks();
+	
+	//! Index one past the Modules readChunks() can run per chunk
+	int chunkPrefix() const;
+	
+	/*!
+	 * \brief Wrap up at the end of a finite Inlet's stream
+	 * 
+	 * Runs every line in flight through the whole Path, then the lines of
+	 * each Module's Module::finishStream() through the rest of it, reports
+	 * the rate achieved, and emits finished().
+	 */
+	void finish();
+	
+	//! Nanoseconds spent in each Module while profiling
+	QVector<qint64> moduleCost;
+	
 	/*!
 	 * Execute the processing loop once
 	 * 
 	 * This function must _only_ be called by a Path's Inlet and while the Path
 	 * is running.  It loops through all Modules and calls Module::process() on
-	 * each one.
+	 * each one.  When batching is enabled, the line is instead stored in the
+	 * current batch, which is run by flushBatch() when full.
 	 */
 	void process();
 	
+	//! Run the current values through Module \a first and everything after it
+	void processFrom(int first);
+	
+	/*!
+	 * \brief Append a Module to the end of the Path
+	 * \param m The Module
+	 * 
+	 * \param inputs The upstream Modules, which must already be appended; the
+	 * previous Module if empty
+	 * 
+	 * Links \a m to the output of its upstream Modules and registers its name
+	 * for findModule().  See the Branches section above.
+	 */
+	void appendModule(Module *m, const ModuleList &inputs = ModuleList());
+	
+	/*!
+	 * \brief Get the input for a new reader of a Module's output
+	 * \param i The index of the upstream Module
+	 * \return Its output, or a new mirror of it if it already has a reader
+	 */
+	const DataDef* branchFrom(int i);
+	
+	//! Reconfigure Module \a i, keeping its join and its mirrors up to date
+	void reconfigureModule(int i);
+	
+	/*!
+	 * \brief Record what Module \a i uses and recompute #deadHandles and #pushdown
+	 * 
+	 * Must be called from the thread running Module \a i after it
+	 * reconfigures.  Modules pick up the result with
+	 * Module::refreshLiveness() and Inlet::refreshPushdown().
+	 */
+	void updateLiveness(int i);
+	
+	//! Have the Plan running Module \a m recompiled; call from its thread
+	void invalidatePlan(Module *m);
+	
+	/*!
+	 * \brief Drop the batch lines which fail Module \a m's filter
+	 * \return The number of lines kept, moved to the front of the batch
+	 */
+	int filterRows(Module *m, int lines);
+	
+	/*!
+	 * \brief Remove the batch lines any Module in \a step dropped
+	 * \return The number of lines kept, moved to the front of the batch
+	 */
+	int dropRows(const PlanStep &step, int lines);
+	
+	//! The Columns Module \a i's mirrors are copied from
+	const DataDef* forkSource(int i) const;
+	
+	//! Bring Module \a i's mirrors up to date with its output's structure
+	void followForks(int i);
+	
+	/*!
+	 * \brief Copy Module \a i's output into the mirrors of its later readers
+	 * \param batch Whether to copy the batch rows rather than current values
+	 */
+	void feedBranches(int i, bool batch);
+	
+	/*!
+	 * \brief Run the current batch through all Modules
+	 * 
+	 * Modules which process batches get a single Module::processBatch() call.
+	 * Runs of line-by-line Modules are driven together, loading each line
+	 * once, calling Module::process() on each, and storing the result.  Does
+	 * nothing if no lines are waiting.  If the batch cannot be sent to the
+	 * first stage yet, nothing is run and the batch is held, growing with
+	 * further lines until resumeSending() sends it.
+	 */
+	void flushBatch();
+	
+	/*!
+	 * \brief Run a batch through a range of Modules
+	 * \param plan The range, compiled first if need be
+	 * \param lines Number of lines in the batch
+	 * \param position Kept at the running Module for return after reconfigure()
+	 * \param cost If set, nanoseconds spent in each Module are added to it
+	 * \return The number of lines left after filters, at the front of the batch
+	 */
+	int runModules(Plan &plan, int lines, int *position, QVector<qint64> *cost = 0);
+	
+	/*!
+	 * \brief Compile a Plan's range of Modules into steps
+	 * 
+	 * Modules which process batches each get a step, except that consecutive
+	 * stateless ones share one and directly linked ones matching a chain
+	 * registered with PathManager share a fused step, unless every Module in
+	 * the chain is stateless and so better sharded.  Runs of line-by-line
+	 * Modules forming a direct chain share a step with a single load and store
+	 * per line.  Batch Modules with a filter start a new step so that it can
+	 * be applied first.
+	 */
+	void compilePlan(Plan &plan);
+	
+	//! Run a FusedChain registered for the step's Modules
+	void runFusedStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost);
+	
+	//! Run one Module's Module::processBatch()
+	void runBatchStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost);
+	
+	//! Run stateless Modules through runStateless()
+	void runStatelessStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost);
+	
+	//! Run line-by-line Modules with one load and store per line, applying their filters
+	void runLineStep(PlanStep &step, int &lines, int *position, QVector<qint64> *cost);
+	
+	/*!
+	 * \brief Run a batch through a run of stateless Modules in parallel
+	 * \param first Index of the first Module
+	 * \param end Index one past the last Module
+	 * \param lines Number of lines in the batch
+	 * 
+	 * The batch is split into row ranges of at least #SHARD_MIN_LINES lines,
+	 * each run through every Module in order by Scheduler::parallelFor(), with
+	 * the calling thread taking its share.  Returns once all are done.
+	 */
+	void runStateless(int first, int end, int lines);
+	
+	//! Reconfigure the Modules of \a s from its position onward on its thread
+	void reconfigureStage(PathStage *s);
+	
+	/*!
+	 * \brief Carry out the calling thread's coalesced reconfigure, if any
+	 * 
+	 * Called at line boundaries: before the Inlet's next line and after each
+	 * Module returns.  Calls to reconfigure() made while this runs are
+	 * absorbed by it.
+	 */
+	void applyReconfigure();
+	
+	//! Index one past the last Module run on the Path's thread
+	int stageEnd() const;
+	
+	/*!
+	 * \brief Take a credit for sending a batch to the first stage
+	 * \return False if none are left, in which case resumeSending() is posted
+	 * once the last stage returns one
+	 * 
+	 * Never blocks, since the Path thread is shared by every Path.  Only call
+	 * from the Path's thread.
+	 */
+	bool takeCredit();
+	
+	//! Give back a credit once a batch leaves the Path; callable from any thread
+	void returnCredit();
+	
+	/*!
+	 * \brief Run a callback once nothing is in flight through the stages
+	 * \param then Run on the Path's thread
+	 * 
+	 * The held batch, if any, is sent first.  A marker is then passed along
+	 * the Strands of the stages in order, so it reaches the end only after
+	 * every earlier batch and reconfigure.  Meanwhile, new batches are held
+	 * on the Path thread and sent once \a then has run.  Runs \a then before
+	 * returning if the Path is not split and nothing is held.
+	 */
+	void whenDrained(const std::function<void()> &then);
+	
+	//! Send the held batch, then start the drain marker; see whenDrained()
+	void drainStages();
+	
+	//! Post the drain marker to stage \a k, or report the drain after the last
+	void passDrainMarker(int k);
+	
+	//! Carry out setStageBoundaries() once the stages have drained
+	void applyStageBoundaries(QList<int> firsts);
+	
+	//! Carry out cleanup() once the stages have drained
+	void cleanupDrained();
+	
+	/*!
+	 * \brief Split Module costs into contiguous stages
+	 * \param cost The cost of each Module
+	 * \param count The number of stages
+	 * \return The index of the first Module of each stage after the first
+	 */
+	static QList<int> balanceStages(const QVector<qint64> &cost, int count);
+	
 	/*!
 	 * \brief Send a high-level message to the user
 	 * \param msg The message
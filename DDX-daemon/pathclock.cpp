@@ -0,0 +1,155 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "pathclock.h"
+#include "daemon_constants.h"
+#include <cmath>
+
+ClockTimer::ClockTimer(PathClock *clock, QObject *parent) : QObject(parent) {
+	this->clock = clock;
+	ms = 0;
+	single = false;
+	active = false;
+	due = 0;
+}
+
+ClockTimer::~ClockTimer() {
+	stop();
+}
+
+void ClockTimer::start() {
+	stop();
+	due = clock->msecsSinceEpoch() + ms;
+	active = true;
+	clock->schedule(this);
+}
+
+void ClockTimer::stop() {
+	if ( ! active) return;
+	active = false;
+	clock->unschedule(this);
+}
+
+PathClock::PathClock(const QTimeZone *tz, QObject *parent) : QObject(parent) {
+	this->tz = tz;
+	rate = 1;
+	virt = false;
+	running = false;
+	origin = 0;
+	advanceQueued = false;
+	wake = new QTimer(this);
+	wake->setSingleShot(true);
+	wake->setTimerType(Qt::PreciseTimer);
+	connect(wake, &QTimer::timeout, this, &PathClock::advance);
+}
+
+void PathClock::setSpeed(double speed, const QDateTime &from) {
+	qint64 before = msecsSinceEpoch();
+	rate = speed < 0 ? 0 : speed;
+	virt = rate != 1 || from.isValid();
+	// A virtual clock continues from where it was; a real one jumps to the wall clock
+	qint64 now = from.isValid() ? from.toMSecsSinceEpoch()
+			: (virt ? before : QDateTime::currentMSecsSinceEpoch());
+	// Timers were due relative to the old clock time
+	qint64 shift = now - before;
+	if (shift && ! pending.isEmpty()) {
+		QMultiMap<qint64, ClockTimer*> moved;
+		QMultiMap<qint64, ClockTimer*>::const_iterator it;
+		for (it = pending.constBegin(); it != pending.constEnd(); ++it) {
+			it.value()->due += shift;
+			moved.insert(it.key() + shift, it.value());
+		}
+		pending = moved;
+	}
+	origin = now;
+	elapsed.start();
+	arm();
+}
+
+qint64 PathClock::msecsSinceEpoch() const {
+	if ( ! virt) return QDateTime::currentMSecsSinceEpoch();
+	if ( ! running || rate == 0) return origin;
+	return origin + (qint64) (elapsed.nsecsElapsed() * rate / 1e6);
+}
+
+QDateTime PathClock::getTime() const {
+	return QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch(), Qt::UTC).toTimeZone(*tz);
+}
+
+void PathClock::start() {
+	if (running) return;
+	elapsed.start();
+	running = true;
+	arm();
+}
+
+void PathClock::pause() {
+	if ( ! running) return;
+	origin = msecsSinceEpoch();
+	running = false;
+	wake->stop();
+}
+
+void PathClock::advance() {
+	advanceQueued = false;
+	if ( ! running) return;
+	qint64 now = msecsSinceEpoch();
+	for (int i = 0; i < CLOCK_BURST_TIMEOUTS && ! pending.isEmpty(); ++i) {
+		QMultiMap<qint64, ClockTimer*>::iterator first = pending.begin();
+		// As fast as possible means jumping straight to the next timeout
+		if (virt && rate == 0) origin = now = qMax(now, first.key());
+		else if (first.key() > now) break;
+		ClockTimer *t = first.value();
+		pending.erase(first);
+		// Rescheduled before emitting, so the slot may stop or restart it
+		if (t->single) t->active = false;
+		else {
+			t->due += t->ms;
+			// Like a QTimer, real time drops the timeouts it fell behind on
+			if ( ! virt && t->due <= now) t->due = now + t->ms;
+			pending.insert(t->due, t);
+		}
+		emit t->timeout();
+	}
+	arm();
+}
+
+void PathClock::schedule(ClockTimer *t) {
+	pending.insert(t->due, t);
+	arm();
+}
+
+void PathClock::unschedule(ClockTimer *t) {
+	pending.remove(t->due, t);
+	arm();
+}
+
+void PathClock::arm() {
+	if ( ! running || pending.isEmpty()) {
+		wake->stop();
+		return;
+	}
+	if (virt && rate == 0) {
+		if (advanceQueued) return;
+		advanceQueued = true;
+		QMetaObject::invokeMethod(this, "advance", Qt::QueuedConnection);
+		return;
+	}
+	double wait = (pending.firstKey() - msecsSinceEpoch()) / (virt ? rate : 1.0);
+	wake->start(wait > 0 ? (int) std::ceil(qMin(wait, 1e9)) : 0);
+}
@@ -0,0 +1,172 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef PATHCLOCK_H
+#define PATHCLOCK_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QElapsedTimer>
+#include <QMultiMap>
+#include <QTimer>
+
+class PathClock;
+
+/*!
+ * \brief A timer which counts its interval in its PathClock's time
+ * 
+ * Used exactly like a QTimer.  While the clock runs in real time it behaves
+ * like one, dropping timeouts it has fallen behind on; on a virtual clock
+ * every timeout fires, in order, at the clock's speed.
+ * 
+ * \ingroup daemon
+ */
+class ClockTimer : public QObject
+{
+	friend class PathClock;
+	Q_OBJECT
+public:
+	
+	explicit ClockTimer(PathClock *clock, QObject *parent = 0);
+	
+	~ClockTimer();
+	
+	//! Set the interval in milliseconds of clock time; takes effect on the next start()
+	void setInterval(int msec) {ms = msec < 0 ? 0 : msec;}
+	
+	int interval() const {return ms;}
+	
+	void setSingleShot(bool singleShot) {single = singleShot;}
+	
+	bool isSingleShot() const {return single;}
+	
+	bool isActive() const {return active;}
+	
+public slots:
+	
+	//! Start or restart the timer
+	void start();
+	
+	void stop();
+	
+signals:
+	
+	void timeout();
+	
+private:
+	PathClock *clock;
+	int ms;
+	bool single;
+	bool active;
+	qint64 due;  //!< Clock time of the next timeout in milliseconds since the epoch
+};
+
+/*!
+ * \brief The time as seen by the Modules of one Path
+ * 
+ * By default this is simply the wall clock.  A virtual clock instead starts
+ * from a chosen time and runs at a multiple of real time, or jumps straight
+ * from one ClockTimer timeout to the next, so a Path driven by timers can
+ * replay a day of recorded data in minutes.  Modules read it with
+ * Module::getTime() instead of Daemon::getTime(), and Inlets pace themselves
+ * with ClockTimer instead of QTimer.
+ * 
+ * Lives on the Path's thread; none of its functions are thread-safe.
+ * 
+ * \ingroup daemon
+ */
+class PathClock : public QObject
+{
+	friend class ClockTimer;
+	Q_OBJECT
+public:
+	
+	//! \param tz The timezone of getTime(), which must outlive the clock
+	PathClock(const QTimeZone *tz, QObject *parent);
+	
+	/*!
+	 * \brief Choose how fast the clock runs
+	 * \param speed Multiple of real time, or 0 for as fast as possible
+	 * \param from Clock time to continue from; the current clock time if invalid
+	 * 
+	 * The clock is virtual unless \a speed is 1 and \a from is invalid, in
+	 * which case it jumps back to the wall clock.  Timers keep their remaining
+	 * time in clock time across every change.
+	 * 
+	 * Schemes have no setting for this, so a replaying Inlet or the code
+	 * building the Path calls it through Path::getClock(), from the Path's
+	 * thread.
+	 */
+	void setSpeed(double speed, const QDateTime &from = QDateTime());
+	
+	double speed() const {return rate;}
+	
+	//! Whether the clock can differ from the wall clock
+	bool isVirtual() const {return virt;}
+	
+	//! The clock time in milliseconds since the epoch
+	qint64 msecsSinceEpoch() const;
+	
+	//! The clock time in DDX standard form; see Daemon::getTime()
+	QDateTime getTime() const;
+	
+	//! Let time pass; called when the Path starts
+	void start();
+	
+	//! Hold a virtual clock still; called when the Path stops
+	void pause();
+	
+private slots:
+	
+	//! Fires every timer which is due, at most #CLOCK_BURST_TIMEOUTS at once
+	void advance();
+	
+private:
+	const QTimeZone *tz;
+	
+	double rate;
+	
+	bool virt;
+	
+	bool running;
+	
+	//! Virtual clock time when #elapsed was started
+	qint64 origin;
+	
+	//! Real time since #origin, for paced virtual clocks
+	QElapsedTimer elapsed;
+	
+	//! Active timers by the clock time they are due
+	QMultiMap<qint64, ClockTimer*> pending;
+	
+	//! Wakes advance() when the earliest timer is due
+	QTimer *wake;
+	
+	//! Whether advance() is already queued on the event loop
+	bool advanceQueued;
+	
+	void schedule(ClockTimer *t);
+	
+	void unschedule(ClockTimer *t);
+	
+	//! Arrange for advance() to run when the earliest timer is due
+	void arm();
+};
+
+#endif // PATHCLOCK_H
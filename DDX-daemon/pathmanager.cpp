@@ -22,6 +22,7 @@
 #include "path.h"
 #include "settings.h"
 #include "logger.h"
+#include "fusedchain.h"
 
 PathManager::PathManager(Daemon *parent) : QObject(parent)
 {
@@ -72,6 +73,9 @@ QString PathManager::verifyPathScheme(const QByteArray scheme) const {
 	if (schemeObj.contains("auto_start"))  // Optional
 		if ( ! schemeObj.value("auto_start").isBool())
 			return tr("Scheme contains an auto_start element which is not a boolean");
+	if (schemeObj.contains("stages"))  // Optional
+		if (schemeObj.value("stages").toInt() < 1)
+			return tr("Scheme contains a stages element which is not a positive integer");
 	if ( ! schemeObj.value("modules").isArray())
 		return tr("Scheme module list is not a JSON array");
 	QJsonArray modArray = schemeObj.value("modules").toArray();
@@ -83,6 +87,8 @@ QString PathManager::verifyPathScheme(const QByteArray scheme) const {
 	QStringList modNameList;
 	Module *moduleInstance;
 	bool firstElement = true;
+	bool branched = false;
+	bool staged = schemeObj.contains("stages");
 	for (i = modArray.constBegin(); i != modArray.constEnd(); ++i) {
 		if ( ! i->isObject())
 			return tr("Scheme contains a module which is not a JSON object");
@@ -92,6 +98,33 @@ QString PathManager::verifyPathScheme(const QByteArray scheme) const {
 		if (obj.contains("s"))  // Settings are optional
 			if ( ! obj.value("s").isObject())
 				return tr("Scheme contains a module whose settings element is not a JSON object");
+		if (obj.contains("new_stage")) {  // Optional
+			if ( ! obj.value("new_stage").isBool())
+				return tr("Scheme contains a module whose new_stage element is not a boolean");
+			if (obj.value("new_stage").toBool() && firstElement)
+				return tr("Scheme's inlet cannot start a new stage");
+			if (obj.value("new_stage").toBool()) staged = true;
+		}
+		if (obj.contains("in")) {  // Optional; defaults to the previous module
+			if (firstElement)
+				return tr("Scheme's inlet cannot have an input");
+			QJsonArray inputs;
+			if (obj.value("in").isArray()) inputs = obj.value("in").toArray();
+			else inputs.append(obj.value("in"));
+			if (inputs.isEmpty())
+				return tr("Scheme contains a module whose input list is empty");
+			for (QJsonArray::const_iterator in = inputs.constBegin(); in != inputs.constEnd(); ++in) {
+				if ( ! in->isString())
+					return tr("Scheme contains a module whose input is not a string");
+				// Inputs must come earlier so that modules run in scheme order
+				if ( ! modNameList.contains(in->toString(), Qt::CaseInsensitive))
+					return tr("Scheme contains a module whose input '%1' is not an earlier module")
+							.arg(in->toString());
+			}
+			branched = true;
+		}
+		if (branched && staged)
+			return tr("Scheme contains both branches and pipeline stages");
 		QString n = obj.value("n").toString();
 		if (n.isEmpty())
 			return tr("Scheme contains a module whose name is empty or not a string");
@@ -138,6 +171,30 @@ Module* PathManager::constructModule(const QString type, Path *parent, const QSt
 													 Q_ARG(QString, name));
 }
 
+FusedChain* PathManager::fuseModules(const QList<Module*> &modules, int *length) const {
+	for (int i = 0; i < fusedChains.size(); ++i) {
+		const FusedChainType &chain = fusedChains.at(i);
+		if (chain.types.size() > modules.size()) continue;
+		int j = 0;
+		while (j < chain.types.size()
+			   && chain.types.at(j) == modules.at(j)->metaObject()->className()) ++j;
+		if (j < chain.types.size()) continue;
+		*length = j;
+		return chain.create(modules);
+	}
+	return 0;
+}
+
+void PathManager::registerFusedChain(const QList<QByteArray> &types, FusedChainFactory create) {
+	FusedChainType chain;
+	chain.types = types;
+	chain.create = create;
+	// Keep the longest chains first so that they win over their prefixes
+	int i = 0;
+	while (i < fusedChains.size() && fusedChains.at(i).types.size() >= types.size()) ++i;
+	fusedChains.insert(i, chain);
+}
+
 void PathManager::handleRpcRequest(const QJsonValue &id, const QString &method, const QJsonValue &params) {
 	
 }
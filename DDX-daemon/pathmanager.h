@@ -30,6 +30,8 @@ class Settings;
 class Module;
 class Inlet;
 class Path;
+class FusedChain;
+template<class... Stages> class FusedChainOf;
 
 /*!
  * \brief Manages the instantiation and configuration of Modules, Beacons, and Paths
@@ -51,6 +53,13 @@ class Path;
  * Failing to register your Modules and Beacons properly can cause them to not
  * be seen by the UnitManager or can crash the application.
  * 
+ * ### Fused Chains
+ * Modules which follow the rules in FusedChainOf can also be registered in
+ * fixed sequences with registerFusedChain() in registerModules().  When a
+ * Path contains a directly linked run of batch Modules whose types match a
+ * registered chain, it runs them through the chain instead, so existing
+ * schemes are fused without any changes.
+ * 
  * \ingroup daemon
  */
 class PathManager : public QObject
@@ -103,6 +112,17 @@ public:
 	 */
 	Module* constructModule(const QString type, Path *parent, const QString name) const;
 	
+	/*!
+	 * \brief Find a registered FusedChain matching the start of a Module run
+	 * \param modules Directly linked batch Modules, in order
+	 * \param length Set to the number of Modules the chain covers
+	 * \return A new FusedChain bound to those Modules, or 0 if none match
+	 * 
+	 * The longest matching chain is used.  This is thread-safe once the
+	 * PathManager has been constructed.
+	 */
+	FusedChain* fuseModules(const QList<Module*> &modules, int *length) const;
+	
 	void handleRpcRequest(const QJsonValue &id, const QString &method, const QJsonValue &params);
 	
 	/*!
@@ -126,6 +146,31 @@ private:
 	
 	//! The list of Modules used to instantiate them by name
 	QHash<QString, QMetaObject> modules;
+	
+	//! Creates a FusedChain bound to the start of a Module list
+	typedef FusedChain* (*FusedChainFactory)(const QList<Module*> &modules);
+	
+	//! A registered FusedChain
+	struct FusedChainType {
+		QList<QByteArray> types;  //!< Module class names, in order
+		FusedChainFactory create;
+	};
+	
+	//! Registered FusedChains, longest first
+	QList<FusedChainType> fusedChains;
+	
+	/*!
+	 * \brief Register a FusedChainOf the given Module types
+	 * 
+	 * Only usable where fusedchain.h is included, which is in
+	 * modules/module_register.cpp.
+	 */
+	template<class... Stages>
+	void registerFusedChain() {
+		registerFusedChain(FusedChainOf<Stages...>::types(), &FusedChainOf<Stages...>::create);
+	}
+	
+	void registerFusedChain(const QList<QByteArray> &types, FusedChainFactory create);
 
 	/*!
 	 * \brief Register all Modules with UnitManager
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "pathstage.h"
+#include "path.h"
+#include "module.h"
+#include "daemon.h"
+#include "daemon_constants.h"
+
+//! The stage whose item the current thread is running
+static thread_local PathStage *currentStage = 0;
+
+PathStage::PathStage(Path *path, int first, int end) :
+	mirror(&path->columnPool), strand(path->d->getScheduler())
+{
+	this->path = path;
+	this->first = first;
+	this->end = end;
+	position = first;
+	reconfigureFrom = -1;
+	reconfiguring = false;
+	lines = 0;
+	next = 0;
+	sentVersion = 0;
+	plan.first = first;
+	plan.end = end;
+	plan.reconfigureFrom = &reconfigureFrom;
+}
+
+PathStage* PathStage::current() {
+	return currentStage;
+}
+
+void PathStage::sendLines(const DataDef *from, int lines) {
+	// Guarantees the batch always matches the mirror it will be loaded into
+	sendSchema(from);
+	Item item;
+	item.kind = Item::Lines;
+	item.lines = lines;
+	item.columns.resize(from->size());
+	int i = 0;
+	spareLock.lock();
+	for (DataDef::const_iterator it = from->begin(); it != from->end(); ++it, ++i) {
+		/* The rows are handed over whole, and the Column gets storage this
+		 * stage is done with, so the next batch neither detaches nor allocates */
+		Column *c = *it;
+		Rows &r = item.columns[i];
+		if (c->isNative()) {
+			r.rows.swap(c->rows);
+			if ( ! spareRows.isEmpty()) {
+				c->rows.swap(spareRows.last());
+				spareRows.removeLast();
+			}
+		}
+		else {
+			r.rowText.swap(c->rowText);
+			if ( ! spareText.isEmpty()) {
+				c->rowText.swap(spareText.last());
+				spareText.removeLast();
+			}
+		}
+		r.dict = c->dict;
+	}
+	spareLock.unlock();
+	push(item);
+}
+
+void PathStage::sendSchema(const DataDef *from) {
+	if (from->version() == sentVersion) return;
+	sentVersion = from->version();
+	Item item;
+	item.kind = Item::Schema;
+	item.lines = 0;
+	item.schema = ColumnMirror::describe(from);
+	push(item);
+}
+
+void PathStage::push(const Item &item) {
+	int queued = depth.fetchAndAddRelaxed(1) + 1;
+	if (queued > highWater.load()) highWater.store(queued);
+	strand.post([this, item]() mutable {
+		handle(item);
+		depth.deref();
+	});
+}
+
+void PathStage::handle(Item &item) {
+	currentStage = this;
+	if (item.kind == Item::Schema) {
+		mirror.setSchema(item.schema);
+		position = first;
+		reconfiguring = true;
+		path->reconfigureStage(this);
+		reconfiguring = false;
+		currentStage = 0;
+		return;
+	}
+#ifdef CAUTIOUS_CHECKS
+	if (item.columns.size() != mirror.columns()->size()) {
+		path->alert("DDX bug: pipeline batch does not match its stage's structure");
+		currentStage = 0;
+		return;
+	}
+#endif
+	int i = 0;
+	const DataDef *in = mirror.columns();
+	for (DataDef::const_iterator it = in->begin(); it != in->end(); ++it, ++i) {
+		Rows &r = item.columns[i];
+		(*it)->rows.swap(r.rows);
+		(*it)->rowText.swap(r.rowText);
+		(*it)->dict = r.dict;
+	}
+	// The item now holds the last batch's rows, which sendLines() can reuse
+	spareLock.lock();
+	for (i = 0; i < item.columns.size(); ++i) {
+		Rows &r = item.columns[i];
+		if (r.rows.capacity()) {
+			spareRows.append(QVector<Column::Value>());
+			spareRows.last().swap(r.rows);
+		}
+		if (r.rowText.capacity()) {
+			spareText.append(QVector<QByteArray>());
+			spareText.last().swap(r.rowText);
+		}
+	}
+	spareLock.unlock();
+	// Later readers of the Inlet are fed from this stage's copy of its output
+	if (path->branched) path->feedBranches(first - 1, true);
+	lines = item.lines;
+	int kept = path->runModules(plan, lines, &position);
+	position = first;
+	lines = 0;
+	// The batch ends here if a filter dropped all of it
+	if (next && kept) next->sendLines(path->modules.at(end - 1)->getOutputColumns(), kept);
+	else path->returnCredit();
+	currentStage = 0;
+}
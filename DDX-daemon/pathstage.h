@@ -0,0 +1,168 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef PATHSTAGE_H
+#define PATHSTAGE_H
+
+#include <QVector>
+#include <QAtomicInt>
+#include <QMutex>
+#include "data.h"
+#include "scheduler.h"
+#include "path.h"
+
+/*!
+ * \brief A run of consecutive Modules executing on its own Strand
+ * 
+ * When a Path is split into stages (see Path::setStageBoundaries()), the
+ * Inlet and the Modules before the first boundary keep running on the Path's
+ * thread, and every later stage runs on the Daemon's Scheduler through a
+ * PathStage.  Each stage is fed batches in order by the stage before it, and
+ * the same Strand carries reconfigures, so downstream stages see them in
+ * exactly the order they happened upstream.  Each Path allows at most
+ * #PIPELINE_QUEUE_DEPTH batches to be in flight across all of its stages.
+ * Beyond that, lines are held on the Path thread and finite Inlets pause
+ * until the last stage returns a credit, which keeps memory bounded and slows
+ * the Path to the pace of its slowest stage.  Nothing ever blocks waiting for
+ * a stage, neither the Path thread, which every Path shares, nor a worker.
+ * 
+ * The first Module of a stage does not read the upstream Columns directly.
+ * Instead it reads #mirror, a ColumnMirror which follows the upstream
+ * output.  Batches are handed over by swapping the upstream row vectors
+ * into the queued item, so a batch crosses a boundary without copying any
+ * values.  The upstream Columns get back storage of an earlier batch which
+ * this stage has finished with, so once as many batches as can be in flight
+ * have passed, rows are neither copied nor allocated; only the queue entry
+ * itself is.  Rows a branch's ColumnMirror still shares are the exception,
+ * and are copied when next written.
+ * 
+ * Modules in stages other than the first have Module::process(),
+ * Module::processBatch() and Module::handleReconfigure() called from a
+ * Scheduler worker.  Those functions must not rely on the thread affinity of
+ * QObjects such as timers.
+ * 
+ * \ingroup daemon
+ */
+class PathStage
+{
+	friend class Path;
+public:
+	
+	/*!
+	 * \param path The Path being split
+	 * \param first Index of this stage's first Module
+	 * \param end Index one past this stage's last Module
+	 */
+	PathStage(Path *path, int first, int end);
+	
+	/*!
+	 * \brief Queue a batch for this stage
+	 * \param from The upstream output Columns
+	 * \param lines Number of lines in the batch
+	 * 
+	 * Must be called by the upstream stage, which for the first stage must
+	 * first take one of the Path's batch credits.
+	 */
+	void sendLines(const DataDef *from, int lines);
+	
+	/*!
+	 * \brief Queue a structure change for this stage
+	 * \param from The upstream output Columns
+	 * 
+	 * Does nothing if \a from has not changed since it was last sent.  Must be
+	 * called by the upstream stage.
+	 */
+	void sendSchema(const DataDef *from);
+	
+	//! The deepest the queue has been
+	int highWaterMark() const {return highWater.load();}
+	
+	//! The stage being run by the calling thread, or 0
+	static PathStage* current();
+	
+private:
+	Q_DISABLE_COPY(PathStage)
+	
+	//! One upstream Column's values for a batch
+	struct Rows {
+		QVector<Column::Value> rows;
+		QVector<QByteArray> rowText;
+		QList<QByteArray> dict;
+	};
+	
+	//! An entry in the queue
+	struct Item {
+		enum Kind {Lines, Schema} kind;
+		int lines;
+		QVector<Rows> columns;  //!< Lines only, in #mirror order
+		QVector<ColumnMirror::Spec> schema;  //!< Schema only
+	};
+	
+	Path *path;
+	
+	int first;  //!< Index of the first Module
+	
+	int end;  //!< Index one past the last Module
+	
+	//! The Module being run, for return after Path::reconfigure()
+	int position;
+	
+	//! First Module awaiting a coalesced reconfigure, or -1
+	int reconfigureFrom;
+	
+	//! Whether this stage is being reconfigured
+	bool reconfiguring;
+	
+	//! Number of lines in the batch being run, or 0 if none is running
+	int lines;
+	
+	//! The stage this one feeds, or 0 for the last stage
+	PathStage *next;
+	
+	//! Follows the upstream output; the input of Module #first
+	ColumnMirror mirror;
+	
+	//! Version of the upstream DataDef last passed to sendSchema()
+	quint64 sentVersion;
+	
+	//! This stage's Modules, compiled on first use
+	Path::Plan plan;
+	
+	//! Items queued and not yet run
+	QAtomicInt depth;
+	
+	QAtomicInt highWater;
+	
+	//! Guards #spareRows and #spareText, which the upstream stage takes from
+	QMutex spareLock;
+	
+	//! Row storage of batches this stage is done with, for sendLines() to reuse
+	QVector<QVector<Column::Value> > spareRows;
+	QVector<QVector<QByteArray> > spareText;
+	
+	//! Declared last, so that its destructor waits for tasks still using the rest
+	Strand strand;
+	
+	//! Queue \a item on #strand
+	void push(const Item &item);
+	
+	//! Run \a item, leaving it the last batch's rows; called on #strand
+	void handle(Item &item);
+};
+
+#endif // PATHSTAGE_H
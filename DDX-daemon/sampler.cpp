@@ -0,0 +1,218 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "sampler.h"
+#include <QJsonArray>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#else
+#include <QElapsedTimer>
+#endif
+
+//! Adds a channel's or the Sampler's counters to \a o
+static void addCounts(QJsonObject &o, quint64 samples, quint64 missed, const quint64 *jitter) {
+	QJsonArray histogram;
+	for (int i = 0; i < SAMPLER_JITTER_BUCKETS; ++i)
+		histogram.append((double) jitter[i]);
+	o.insert("Samples", (double) samples);
+	o.insert("Missed", (double) missed);
+	o.insert("JitterHistogram", histogram);
+}
+
+Sampler::Sampler(QObject *parent) : QThread(parent) {
+	nextId = 0;
+	quitting = false;
+	wakeups = 0;
+	memset(&removed.jitter, 0, sizeof(removed.jitter));
+	removed.samples = 0;
+	removed.missed = 0;
+	timerFd = eventFd = -1;
+#ifdef Q_OS_LINUX
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+	setObjectName("Sampler");
+	start(QThread::TimeCriticalPriority);
+}
+
+Sampler::~Sampler() {
+	lock.lock();
+	quitting = true;
+	interrupt();
+	lock.unlock();
+	wait();
+	qDeleteAll(channels);
+#ifdef Q_OS_LINUX
+	if (timerFd >= 0) close(timerFd);
+	if (eventFd >= 0) close(eventFd);
+#endif
+}
+
+qint64 Sampler::now() {
+#ifdef Q_OS_LINUX
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * Q_INT64_C(1000000000) + ts.tv_nsec;
+#else
+	QElapsedTimer t;
+	t.start();
+	return t.msecsSinceReference() * 1000000;
+#endif
+}
+
+int Sampler::addChannel(qint64 period, const Sample &sample) {
+	if (period <= 0) return -1;
+	Channel *c = new Channel;
+	c->period = period;
+	// Aligned deadlines let channels with related periods share wakeups
+	c->next = (now() / period + 1) * period;
+	c->sample = sample;
+	c->samples = 0;
+	c->missed = 0;
+	memset(c->jitter, 0, sizeof(c->jitter));
+	QMutexLocker l(&lock);
+	int id = nextId++;
+	channels.insert(id, c);
+	interrupt();
+	return id;
+}
+
+void Sampler::removeChannel(int id) {
+	QMutexLocker l(&lock);
+	Channel *c = channels.take(id);
+	if ( ! c) return;
+	removed.samples += c->samples;
+	removed.missed += c->missed;
+	for (int i = 0; i < SAMPLER_JITTER_BUCKETS; ++i)
+		removed.jitter[i] += c->jitter[i];
+	delete c;
+	interrupt();
+}
+
+QJsonObject Sampler::channelStats(int id) const {
+	QJsonObject o;
+	QMutexLocker l(&lock);
+	Channel *c = channels.value(id, 0);
+	if ( ! c) return o;
+	o.insert("Period", (double) c->period);
+	addCounts(o, c->samples, c->missed, c->jitter);
+	return o;
+}
+
+QJsonObject Sampler::publishStats() const {
+	QJsonObject o;
+	QMutexLocker l(&lock);
+	quint64 samples = removed.samples, missed = removed.missed;
+	quint64 jitter[SAMPLER_JITTER_BUCKETS];
+	memcpy(jitter, removed.jitter, sizeof(jitter));
+	QHash<int, Channel*>::const_iterator it;
+	for (it = channels.constBegin(); it != channels.constEnd(); ++it) {
+		samples += it.value()->samples;
+		missed += it.value()->missed;
+		for (int i = 0; i < SAMPLER_JITTER_BUCKETS; ++i)
+			jitter[i] += it.value()->jitter[i];
+	}
+	o.insert("Channels", channels.size());
+	o.insert("Wakeups", (double) wakeups);
+	addCounts(o, samples, missed, jitter);
+	return o;
+}
+
+void Sampler::interrupt() {
+#ifdef Q_OS_LINUX
+	if (eventFd >= 0) {
+		quint64 one = 1;
+		if (write(eventFd, &one, sizeof(one)) == sizeof(one)) return;
+	}
+#endif
+	changed.wakeAll();
+}
+
+void Sampler::run() {
+	lock.lock();
+	while ( ! quitting) {
+		qint64 due = -1;
+		QHash<int, Channel*>::const_iterator it;
+		for (it = channels.constBegin(); it != channels.constEnd(); ++it)
+			if (due < 0 || it.value()->next < due) due = it.value()->next;
+#ifdef Q_OS_LINUX
+		if (timerFd >= 0 && eventFd >= 0) {
+			itimerspec spec;
+			memset(&spec, 0, sizeof(spec));
+			if (due >= 0) {
+				// An all-zero value would disarm the timer instead
+				spec.it_value.tv_sec = due / 1000000000;
+				spec.it_value.tv_nsec = qMax(due % 1000000000, (qint64) 1);
+			}
+			timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, 0);
+			lock.unlock();
+			pollfd fds[2] = {{timerFd, POLLIN, 0}, {eventFd, POLLIN, 0}};
+			poll(fds, 2, -1);
+			// Both are only read to clear them
+			quint64 count;
+			ssize_t r = 0;
+			if (fds[0].revents & POLLIN) r = read(timerFd, &count, sizeof(count));
+			if (fds[1].revents & POLLIN) r = read(eventFd, &count, sizeof(count));
+			(void) r;
+			lock.lock();
+			sampleDue();
+			continue;
+		}
+#endif
+		if (due < 0) changed.wait(&lock);
+		else {
+			qint64 wait = due - now();
+			if (wait > 0) changed.wait(&lock, (unsigned long) ((wait + 999999) / 1000000));
+		}
+		sampleDue();
+	}
+	lock.unlock();
+}
+
+void Sampler::sampleDue() {
+	qint64 t = now();
+	bool woke = false;
+	QHash<int, Channel*>::iterator it;
+	for (it = channels.begin(); it != channels.end(); ++it) {
+		Channel *c = it.value();
+		if (c->next > t) continue;
+		woke = true;
+		qint64 late = (t - c->next) / 1000;
+		int bucket = 0;
+		while (late && bucket < SAMPLER_JITTER_BUCKETS - 1) {
+			late >>= 1;
+			++bucket;
+		}
+		c->jitter[bucket]++;
+		c->sample(c->next);
+		c->samples++;
+		c->next += c->period;
+		// Deadlines which passed while sampling was late are skipped
+		if (c->next <= t) {
+			qint64 skipped = (t - c->next) / c->period + 1;
+			c->missed += skipped;
+			c->next += skipped * c->period;
+		}
+	}
+	if (woke) ++wakeups;
+}
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QJsonObject>
+#include <functional>
+#include "daemon_constants.h"
+
+/*!
+ * \brief A shared high-resolution thread which samples polled instruments
+ * 
+ * Inlets which poll hardware at fixed rates register a channel with a period
+ * and a sampling function instead of running a QTimer each.  Deadlines are
+ * absolute multiples of the period on the monotonic clock, so channels never
+ * drift, and channels whose periods divide each other share deadlines and
+ * are all sampled in one wakeup.  On Linux the thread sleeps on a timerfd
+ * armed with the absolute deadline; elsewhere it falls back to a
+ * millisecond wait.
+ * 
+ * How late each sample ran is kept in a histogram of power-of-two
+ * microsecond buckets per channel.  Deadlines which pass entirely before the
+ * thread wakes are skipped and counted rather than sampled late.
+ * 
+ * Virtual time does not apply here; see PathClock for paced replays.
+ * 
+ * \ingroup daemon
+ */
+class Sampler : public QThread
+{
+	Q_OBJECT
+public:
+	
+	/*!
+	 * \brief A sampling function
+	 * 
+	 * Called on the Sampler's thread with the deadline it was scheduled for,
+	 * in nanoseconds on the monotonic clock (the same reference as
+	 * QElapsedTimer).  It must return quickly, must not block, and must not
+	 * add or remove channels; hand readings to the Path thread through a
+	 * FailQueue (see Inlet::attachQueue()).
+	 */
+	typedef std::function<void(qint64 deadline)> Sample;
+	
+	explicit Sampler(QObject *parent = 0);
+	
+	//! Stops the thread
+	~Sampler();
+	
+	/*!
+	 * \brief Start sampling a channel
+	 * \param period The period in nanoseconds
+	 * \param sample The sampling function
+	 * \return An ID for removeChannel(), or -1 if \a period is not positive
+	 * 
+	 * The first deadline is the next multiple of \a period.  Thread-safe.
+	 */
+	int addChannel(qint64 period, const Sample &sample);
+	
+	/*!
+	 * \brief Stop sampling a channel
+	 * \param id The ID returned by addChannel()
+	 * 
+	 * Once this returns, the sampling function is not running and will not
+	 * be called again.  Thread-safe, but not from a sampling function.
+	 */
+	void removeChannel(int id);
+	
+	/*!
+	 * \brief Report the statistics of one channel
+	 * \return A JSON object with the period, samples taken, deadlines missed
+	 * and the jitter histogram, whose bucket \a i counts samples which ran
+	 * less than 2^i microseconds late
+	 */
+	QJsonObject channelStats(int id) const;
+	
+	/*!
+	 * \brief Report runtime statistics
+	 * \return A JSON object with the number of channels, wakeups and samples,
+	 * deadlines missed and the jitter histogram of all channels together
+	 */
+	QJsonObject publishStats() const;
+	
+	//! The current time in nanoseconds on the clock deadlines are measured by
+	static qint64 now();
+	
+protected:
+	
+	void run() override;
+	
+private:
+	struct Channel {
+		qint64 period;
+		qint64 next;  //!< The next deadline
+		Sample sample;
+		quint64 samples;
+		quint64 missed;
+		quint64 jitter[SAMPLER_JITTER_BUCKETS];
+	};
+	
+	mutable QMutex lock;
+	
+	//! Signals changes to the fallback wait
+	QWaitCondition changed;
+	
+	QHash<int, Channel*> channels;
+	
+	int nextId;
+	
+	bool quitting;
+	
+	quint64 wakeups;
+	
+	//! Totals of removed channels, so that publishStats() never goes backwards
+	Channel removed;
+	
+	//! The timerfd the thread sleeps on, or -1
+	int timerFd;
+	
+	//! An eventfd which wakes the thread when channels change, or -1
+	int eventFd;
+	
+	//! Wake the thread to recompute its deadline; called with #lock held
+	void interrupt();
+	
+	//! Sample every channel which is due; called with #lock held
+	void sampleDue();
+};
+
+#endif // SAMPLER_H
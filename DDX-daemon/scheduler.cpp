@@ -0,0 +1,233 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#include "scheduler.h"
+#include "daemon_constants.h"
+#include <QJsonArray>
+#include <memory>
+
+//! The Scheduler whose worker is the current thread, if any
+static thread_local const Scheduler *currentScheduler = 0;
+
+//! The index of the current thread's worker within #currentScheduler
+static thread_local int currentWorker = -1;
+
+/*!
+ * \brief State shared by the caller and helpers of one Scheduler::parallelFor()
+ * 
+ * Owned jointly, since a helper may only be run after every index is done.
+ */
+class ParallelFor
+{
+public:
+	std::function<void(int)> body;
+	int count;
+	QAtomicInt next;
+	QAtomicInt left;
+	QMutex lock;
+	QWaitCondition done;
+	
+	//! Claim and run indices until none are left
+	void work() {
+		int i;
+		while ((i = next.fetchAndAddRelaxed(1)) < count) {
+			body(i);
+			if ( ! left.deref()) {
+				QMutexLocker l(&lock);
+				done.wakeAll();
+			}
+		}
+	}
+};
+
+Strand::Strand(Scheduler *scheduler) {
+	this->scheduler = scheduler;
+	scheduled = false;
+}
+
+Strand::~Strand() {
+	wait();
+}
+
+void Strand::post(const std::function<void()> &task) {
+	lock.lock();
+	tasks.enqueue(task);
+	depth.ref();
+	bool start = ! scheduled;
+	scheduled = true;
+	lock.unlock();
+	if (start) scheduler->schedule(this);
+}
+
+void Strand::wait() {
+	QMutexLocker l(&lock);
+	while (scheduled) idle.wait(&lock);
+}
+
+void Strand::run() {
+	for (int i = 0; i < SCHEDULER_STRAND_BUDGET; ++i) {
+		lock.lock();
+		if (tasks.isEmpty()) {
+			scheduled = false;
+			idle.wakeAll();
+			lock.unlock();
+			return;
+		}
+		std::function<void()> task = tasks.dequeue();
+		lock.unlock();
+		task();
+		depth.deref();
+	}
+	// Out of budget; go to the back of the line if there is more to do
+	lock.lock();
+	if (tasks.isEmpty()) {
+		scheduled = false;
+		idle.wakeAll();
+		lock.unlock();
+		return;
+	}
+	lock.unlock();
+	scheduler->schedule(this);
+}
+
+Scheduler::Scheduler(int workers) {
+	stopping = false;
+	if (workers < 1) workers = QThread::idealThreadCount();
+	if (workers < 1) workers = 1;
+	for (int i = 0; i < workers; ++i)
+		this->workers.append(new Worker(this, i));
+	// Workers read the list, so it must be complete before any start
+	for (int i = 0; i < workers; ++i)
+		this->workers.at(i)->start();
+	for (int i = 0; i < workers; ++i)
+		helpers.append(new Strand(this));
+}
+
+Scheduler::~Scheduler() {
+	qDeleteAll(helpers);
+	sleepLock.lock();
+	stopping = true;
+	wake.wakeAll();
+	sleepLock.unlock();
+	for (int i = 0; i < workers.size(); ++i)
+		workers.at(i)->wait();
+	qDeleteAll(workers);
+}
+
+QJsonObject Scheduler::publishStats() const {
+	QJsonObject o;
+	QJsonArray depths;
+	int highWater = 0;
+	double runs = 0, steals = 0;
+	for (int i = 0; i < workers.size(); ++i) {
+		Worker *w = workers.at(i);
+		depths.append(w->depth.load());
+		highWater = qMax(highWater, w->highWater.load());
+		runs += w->runs.load();
+		steals += w->steals.load();
+	}
+	o.insert("Workers", workers.size());
+	o.insert("QueueDepths", depths);
+	o.insert("QueueHighWater", highWater);
+	o.insert("Runs", runs);
+	o.insert("Steals", steals);
+	return o;
+}
+
+void Scheduler::parallelFor(int count, const std::function<void(int)> &body) {
+	if (count < 1) return;
+	if (count == 1) {
+		body(0);
+		return;
+	}
+	std::shared_ptr<ParallelFor> p = std::make_shared<ParallelFor>();
+	p->body = body;
+	p->count = count;
+	p->left.store(count);
+	int n = qMin(count - 1, helpers.size());
+	for (int k = 0; k < n; ++k) {
+		Strand *h = helpers.at((nextHelper.fetchAndAddRelaxed(1) & 0x7fffffff) % helpers.size());
+		h->post([p]() {p->work();});
+	}
+	p->work();
+	// Whatever is left is already being run by a helper
+	QMutexLocker l(&p->lock);
+	while (p->left.loadAcquire()) p->done.wait(&p->lock);
+}
+
+void Scheduler::schedule(Strand *s) {
+	int i;
+	if (currentScheduler == this) i = currentWorker;
+	else i = (nextWorker.fetchAndAddRelaxed(1) & 0x7fffffff) % workers.size();
+	Worker *w = workers.at(i);
+	w->lock.lock();
+	w->deque.append(s);
+	int depth = w->depth.fetchAndAddRelaxed(1) + 1;
+	if (depth > w->highWater.load()) w->highWater.store(depth);
+	w->lock.unlock();
+	queued.ref();
+	// Taking the lock keeps a worker from missing this between check and sleep
+	sleepLock.lock();
+	wake.wakeOne();
+	sleepLock.unlock();
+}
+
+Strand* Scheduler::take(Worker *w) {
+	Strand *s = 0;
+	w->lock.lock();
+	if ( ! w->deque.isEmpty()) s = w->deque.takeFirst();
+	w->lock.unlock();
+	if (s) {
+		w->depth.deref();
+		return s;
+	}
+	// Steal from the other end of somebody else's deque
+	for (int k = 1; k < workers.size() && ! s; ++k) {
+		Worker *victim = workers.at((w->index + k) % workers.size());
+		if ( ! victim->depth.load()) continue;
+		victim->lock.lock();
+		if ( ! victim->deque.isEmpty()) s = victim->deque.takeLast();
+		victim->lock.unlock();
+		if (s) {
+			victim->depth.deref();
+			w->steals.ref();
+		}
+	}
+	return s;
+}
+
+void Scheduler::Worker::run() {
+	currentScheduler = scheduler;
+	currentWorker = index;
+	forever {
+		Strand *s = scheduler->take(this);
+		if (s) {
+			scheduler->queued.deref();
+			runs.ref();
+			s->run();
+			continue;
+		}
+		scheduler->sleepLock.lock();
+		if (scheduler->stopping) {
+			scheduler->sleepLock.unlock();
+			return;
+		}
+		if ( ! scheduler->queued.load()) scheduler->wake.wait(&scheduler->sleepLock);
+		scheduler->sleepLock.unlock();
+	}
+}
@@ -0,0 +1,187 @@
+/******************************************************************************
+ *                         DATA DISPLAY APPLICATION X                         *
+ *                            2B TECHNOLOGIES, INC.                           *
+ *                                                                            *
+ * The DDX is free software: you can redistribute it and/or modify it under   *
+ * the terms of the GNU General Public License as published by the Free       *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.  The DDX is distributed in the hope that it will be     *
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General  *
+ * Public License for more details.  You should have received a copy of the   *
+ * GNU General Public License along with the DDX.  If not, see                *
+ * <http://www.gnu.org/licenses/>.                                            *
+ *                                                                            *
+ *  For more information about the DDX, check out the 2B website or GitHub:   *
+ *       <http://twobtech.com/DDX>       <https://github.com/2BTech/DDX>      *
+ ******************************************************************************/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QAtomicInt>
+#include <QJsonObject>
+#include <functional>
+
+class Scheduler;
+
+/*!
+ * \brief A sequence of tasks which run one at a time, in order
+ * 
+ * Tasks posted to a Strand run on whichever Scheduler worker picks the
+ * Strand up, but never two at once and always in the order they were posted.
+ * Each Path stage has its own Strand, so a Path's work keeps its order while
+ * Paths share a fixed number of threads.
+ * 
+ * \ingroup daemon
+ */
+class Strand
+{
+	friend class Scheduler;
+public:
+	
+	explicit Strand(Scheduler *scheduler);
+	
+	//! Waits for all posted tasks to run
+	~Strand();
+	
+	/*!
+	 * \brief Queue a task
+	 * \param task The task, which must not block on other Strands
+	 * 
+	 * Can be called from any thread.
+	 */
+	void post(const std::function<void()> &task);
+	
+	//! Block until every task posted so far has run; not from this Strand
+	void wait();
+	
+	//! The number of tasks waiting to run
+	int pending() const {return depth.load();}
+	
+private:
+	Q_DISABLE_COPY(Strand)
+	
+	Scheduler *scheduler;
+	
+	QMutex lock;
+	
+	QWaitCondition idle;
+	
+	QQueue<std::function<void()> > tasks;
+	
+	QAtomicInt depth;
+	
+	//! Whether the Strand is queued on or being run by a worker
+	bool scheduled;
+	
+	/*!
+	 * \brief Run waiting tasks
+	 * 
+	 * Runs at most #SCHEDULER_STRAND_BUDGET tasks so that a busy Strand cannot
+	 * starve others, then reschedules itself if any are left.
+	 */
+	void run();
+};
+
+/*!
+ * \brief A fixed pool of worker threads which run Strands
+ * 
+ * Replaces a thread per Path.  There is one worker per core, each with its
+ * own deque of Strands waiting to run.  Strands scheduled from a worker go on
+ * its own deque; others are dealt out in turn.  A worker takes from the front
+ * of its own deque and, when that is empty, steals from the back of another
+ * worker's, so one busy Path cannot leave cores idle while others wait.
+ * 
+ * Tasks must not block waiting for other Strands, since a blocked worker
+ * cannot run anything else.
+ * 
+ * \ingroup daemon
+ */
+class Scheduler
+{
+	friend class Strand;
+public:
+	
+	//! \param workers The number of worker threads; one per core if 0
+	explicit Scheduler(int workers = 0);
+	
+	//! Finishes the workers; Strands must be idle
+	~Scheduler();
+	
+	//! The number of worker threads
+	int workerCount() const {return workers.size();}
+	
+	/*!
+	 * \brief Run \a body for every index below \a count, in parallel
+	 * \param count The number of indices
+	 * \param body Called once per index, from any thread
+	 * 
+	 * The calling thread claims indices one at a time, and so do up to one
+	 * helper Strand per worker as workers come free.  Returns once every
+	 * index has run.  The caller only ever waits for indices already being
+	 * run, never for work queued behind other Strands, so this may be called
+	 * from a worker and from the Path thread alike.
+	 */
+	void parallelFor(int count, const std::function<void(int)> &body);
+	
+	/*!
+	 * \brief Report runtime statistics
+	 * \return A JSON object with the Strands waiting on each worker, the
+	 * deepest any worker's deque has been, and the total number of Strand
+	 * runs and steals
+	 */
+	QJsonObject publishStats() const;
+	
+private:
+	Q_DISABLE_COPY(Scheduler)
+	
+	class Worker : public QThread
+	{
+	public:
+		Worker(Scheduler *scheduler, int index) : scheduler(scheduler), index(index) {}
+		
+		Scheduler *scheduler;
+		int index;
+		QMutex lock;
+		QList<Strand*> deque;
+		QAtomicInt depth;
+		QAtomicInt highWater;
+		QAtomicInt runs;
+		QAtomicInt steals;
+		
+	protected:
+		void run() override;
+	};
+	
+	QList<Worker*> workers;
+	
+	//! One Strand per worker which helps with parallelFor()
+	QList<Strand*> helpers;
+	
+	//! Next helper to post to
+	QAtomicInt nextHelper;
+	
+	//! Strands queued on any deque
+	QAtomicInt queued;
+	
+	//! Next worker for Strands scheduled from outside the pool
+	QAtomicInt nextWorker;
+	
+	QMutex sleepLock;
+	QWaitCondition wake;
+	bool stopping;
+	
+	//! Queue \a s on a worker's deque
+	void schedule(Strand *s);
+	
+	//! Take a Strand for \a w, stealing if its deque is empty
+	Strand* take(Worker *w);
+};
+
+#endif // SCHEDULER_H
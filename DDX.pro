@@ -21,4 +21,5 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     DDX-testgui \	# Test GUI/RPC system
-    DDX-daemon		# Data collection, instrument setup & communication, uploading, logging
+    DDX-daemon \	# Data collection, instrument setup & communication, uploading, logging
+    DDX-benchmarks	# Timings of the daemon's hot paths